@@ -0,0 +1,130 @@
+#define SDL_MAIN_HANDLED
+#include "entity.hpp"
+#include <SDL.h>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+// Compares the templated onCollide of moveX/moveY with the std::function form
+// they used to take. 10k walls sit on a lattice and one mover per row sweeps
+// back and forth through them. onCollide lets every contact through, so it is
+// called for each wall crossed.
+//
+// usage: bench_collision [moves per mover]
+
+const int kWallColumns = 100;
+const int kWallRows = 100;
+const float kWallSpacing = 16.0F;
+const float kStep = 40.0F;
+
+struct Mover : Entity {
+    float hsp = kStep;
+    uint64_t numContacts = 0;
+};
+
+void resetMovers(std::vector<Mover>& movers)
+{
+    for (size_t i = 0; i < movers.size(); ++i)
+    {
+        Mover& m = movers[i];
+        m.position = vec3(-8.0F, float(i) * kWallSpacing + 2.0F, 0.0F);
+        m.hsp = kStep;
+        m.numContacts = 0;
+        m.syncArea();
+    }
+}
+
+// turns around at either end of its row.
+template <typename Step>
+double runMovers(std::vector<Mover>& movers, uint32_t numMoves, Step step)
+{
+    uint64_t start = SDL_GetPerformanceCounter();
+    for (uint32_t n = 0; n < numMoves; ++n)
+    {
+        for (Mover& m : movers)
+        {
+            step(m);
+            if (m.position.x > kWallColumns * kWallSpacing || m.position.x < -8.0F)
+            {
+                m.hsp = -m.hsp;
+            }
+        }
+    }
+    return double(SDL_GetPerformanceCounter() - start) / double(SDL_GetPerformanceFrequency());
+}
+
+uint64_t sumContacts(const std::vector<Mover>& movers)
+{
+    uint64_t sum = 0;
+    for (const Mover& m : movers)
+    {
+        sum += m.numContacts;
+    }
+    return sum;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t numMoves = argc > 1 ? uint32_t(strtoul(argv[1], nullptr, 10)) : 2000;
+
+    std::vector<Entity> walls(kWallColumns * kWallRows);
+    for (int y = 0; y < kWallRows; ++y)
+    {
+        for (int x = 0; x < kWallColumns; ++x)
+        {
+            Entity& w = walls[y * kWallColumns + x];
+            w.position = vec3(float(x) * kWallSpacing, float(y) * kWallSpacing, 0.0F);
+            w.hitbox = Rect(0.0F, 0.0F, 8.0F, 8.0F);
+            Entity::addEntity(&w);
+        }
+    }
+    std::vector<Mover> movers(kWallRows);
+    for (Mover& m : movers)
+    {
+        m.hitbox = Rect(0.0F, 0.0F, 4.0F, 4.0F);
+        Entity::addEntity(&m);
+    }
+
+    double bestTemplate = 1.0e9;
+    double bestFunction = 1.0e9;
+    uint64_t contactsTemplate = 0;
+    uint64_t contactsFunction = 0;
+    for (int round = 0; round < 3; ++round)
+    {
+        resetMovers(movers);
+        double t = runMovers(movers, numMoves, [](Mover& m) {
+            m.moveX(m.hsp, [&m](const Contact&) {
+                m.numContacts++;
+                return false;
+            });
+        });
+        bestTemplate = std::min(bestTemplate, t);
+        contactsTemplate = sumContacts(movers);
+
+        resetMovers(movers);
+        t = runMovers(movers, numMoves, [](Mover& m) {
+            // the old signature: a capturing lambda wrapped in a std::function on every call.
+            std::function<bool(const Contact&)> onCollide = [&m](const Contact&) {
+                m.numContacts++;
+                return false;
+            };
+            m.moveX(m.hsp, onCollide);
+        });
+        bestFunction = std::min(bestFunction, t);
+        contactsFunction = sumContacts(movers);
+    }
+
+    uint64_t numSweeps = uint64_t(numMoves) * movers.size();
+    printf("bench_collision: walls: %zu, movers: %zu, moves per mover: %u, contacts per run: %llu\n",
+           walls.size(), movers.size(), numMoves, (unsigned long long)contactsTemplate);
+    printf("  template:      %.3f s, %.0f moves/s\n", bestTemplate, double(numSweeps) / bestTemplate);
+    printf("  std::function: %.3f s, %.0f moves/s\n", bestFunction, double(numSweeps) / bestFunction);
+    printf("  speedup: %.2fx\n", bestFunction / bestTemplate);
+    if (contactsTemplate != contactsFunction)
+    {
+        printf("bench_collision: contact counts differ: %llu vs %llu\n", (unsigned long long)contactsTemplate, (unsigned long long)contactsFunction);
+        return 1;
+    }
+    return 0;
+}
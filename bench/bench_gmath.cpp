@@ -0,0 +1,110 @@
+#include "gmath.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Throughput of mat4Multiply and vec4Transform against their scalar
+// references, and a check that both give bit-identical results. Built as
+// bench_gmath (SSE2), bench_gmath_avx and bench_gmath_scalar.
+//
+// usage: bench_gmath [rounds]
+
+#if defined(GMATH_AVX)
+const char* kPath = "avx";
+#elif defined(GMATH_SSE2)
+const char* kPath = "sse2";
+#else
+const char* kPath = "scalar";
+#endif
+
+const size_t kCount = 1024;
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Multiply>
+double timeMultiply(const std::vector<Matrix4>& a, const std::vector<Matrix4>& b, std::vector<Matrix4>& out, uint32_t rounds, Multiply multiply)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < rounds; ++r)
+    {
+        for (size_t i = 0; i < kCount; ++i)
+        {
+            out[i] = multiply(a[i], b[(i + r) % kCount]);
+        }
+    }
+    return secondsSince(start);
+}
+
+template <typename Transform>
+double timeTransform(const std::vector<Vector4>& v, const std::vector<Matrix4>& m, std::vector<Vector4>& out, uint32_t rounds, Transform transform)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < rounds; ++r)
+    {
+        for (size_t i = 0; i < kCount; ++i)
+        {
+            out[i] = transform(v[i], m[(i + r) % kCount]);
+        }
+    }
+    return secondsSince(start);
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t rounds = argc > 1 ? uint32_t(strtoul(argv[1], nullptr, 10)) : 10000;
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> dist(-100.0F, 100.0F);
+    std::vector<Matrix4> a(kCount), b(kCount), out(kCount);
+    std::vector<Vector4> v(kCount), vout(kCount);
+    for (size_t i = 0; i < kCount; ++i)
+    {
+        float* pa = (float*)&a[i];
+        float* pb = (float*)&b[i];
+        for (int k = 0; k < 16; ++k)
+        {
+            pa[k] = dist(rng);
+            pb[k] = dist(rng);
+        }
+        v[i] = {dist(rng), dist(rng), dist(rng), 1.0F};
+    }
+    // the matrices drawSprite actually multiplies.
+    a[0] = mat4CreateTranslation(vec3(123.5F, -45.25F, 0.0F));
+    b[0] = mat4CreateScale(vec3(32.0F, -32.0F, 1.0F));
+
+    uint64_t numMismatches = 0;
+    for (size_t i = 0; i < kCount; ++i)
+    {
+        for (size_t j = 0; j < kCount; j += 7)
+        {
+            Matrix4 simd = mat4Multiply(a[i], b[j]);
+            Matrix4 scalar = mat4MultiplyScalar(a[i], b[j]);
+            numMismatches += memcmp(&simd, &scalar, sizeof(Matrix4)) != 0 ? 1 : 0;
+            Vector4 vs = vec4Transform(v[i], a[j]);
+            Vector4 vr = vec4TransformScalar(v[i], a[j]);
+            numMismatches += memcmp(&vs, &vr, sizeof(Vector4)) != 0 ? 1 : 0;
+        }
+    }
+
+    double ops = double(rounds) * kCount;
+    double mulPath = timeMultiply(a, b, out, rounds, [](const Matrix4& x, const Matrix4& y) { return mat4Multiply(x, y); });
+    double mulScalar = timeMultiply(a, b, out, rounds, [](const Matrix4& x, const Matrix4& y) { return mat4MultiplyScalar(x, y); });
+    double xfPath = timeTransform(v, a, vout, rounds, [](const Vector4& x, const Matrix4& y) { return vec4Transform(x, y); });
+    double xfScalar = timeTransform(v, a, vout, rounds, [](const Vector4& x, const Matrix4& y) { return vec4TransformScalar(x, y); });
+    // keeps the timed loops from being optimized away.
+    volatile float sink = out[kCount / 2].m11 + vout[kCount / 2].x;
+    (void)sink;
+
+    printf("bench_gmath: path: %s, %.0f calls each\n", kPath, ops);
+    printf("  mat4Multiply:  %s %.1f M/s, scalar %.1f M/s\n", kPath, ops / mulPath / 1.0e6, ops / mulScalar / 1.0e6);
+    printf("  vec4Transform: %s %.1f M/s, scalar %.1f M/s\n", kPath, ops / xfPath / 1.0e6, ops / xfScalar / 1.0e6);
+    printf("  bit-identical to scalar: %s (%llu mismatches)\n", numMismatches == 0 ? "yes" : "NO", (unsigned long long)numMismatches);
+    return numMismatches == 0 ? 0 : 1;
+}
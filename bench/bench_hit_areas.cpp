@@ -0,0 +1,116 @@
+#define SDL_MAIN_HANDLED
+#include "entity.hpp"
+#include <SDL.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Compares the broadphase filter reading hit areas from the registry's packed
+// array with the old one, which dereferenced every grid candidate to compute
+// its hit area. Entities are heap-allocated one by one in shuffled order with
+// a payload the size of a game object, so candidates are scattered in memory
+// the way they are in a long-running game. Queries cover a few cells of a
+// dense crowd, and about half of the candidates are rejected.
+//
+// usage: bench_hit_areas [entities] [queries]
+
+const float kWorldSize = 4096.0F;
+const float kQuerySize = 64.0F;
+
+// stands in for the sprite sheets, input and state of a real entity.
+struct Crowd : Entity {
+    uint8_t payload[384] = {};
+};
+
+// Entity::queryEntities before the packed hit-area array.
+void queryEntitiesOld(const Rect& area, std::vector<Entity*>& out)
+{
+    Entity::querySlots(area, Entity::slotScratch);
+    out.clear();
+    for (uint32_t slot : Entity::slotScratch)
+    {
+        Entity* e = Entity::registry.getAt(slot);
+        if (area.isHit(e->getHitArea()))
+        {
+            out.push_back(e);
+        }
+    }
+}
+
+template <typename Query>
+double runQueries(const std::vector<Rect>& queries, uint64_t& numHits, Query query)
+{
+    std::vector<Entity*> out;
+    numHits = 0;
+    uint64_t start = SDL_GetPerformanceCounter();
+    for (const Rect& q : queries)
+    {
+        query(q, out);
+        numHits += out.size();
+    }
+    return double(SDL_GetPerformanceCounter() - start) / double(SDL_GetPerformanceFrequency());
+}
+
+int main(int argc, char** argv)
+{
+    size_t numEntities = argc > 1 ? size_t(strtoul(argv[1], nullptr, 10)) : 200000;
+    size_t numQueries = argc > 2 ? size_t(strtoul(argv[2], nullptr, 10)) : 50000;
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> randPos(0.0F, kWorldSize);
+    std::vector<std::unique_ptr<Crowd>> crowd(numEntities);
+    for (auto& c : crowd)
+    {
+        c = std::make_unique<Crowd>();
+    }
+    // registered in a different order than allocated, so neighbouring slots are far apart.
+    std::shuffle(crowd.begin(), crowd.end(), rng);
+    for (auto& c : crowd)
+    {
+        c->position = vec3(floorf(randPos(rng)), floorf(randPos(rng)), 0.0F);
+        c->hitbox = Rect(-3.0F, -4.0F, 6.0F, 9.0F);
+        Entity::addEntity(c.get());
+    }
+
+    std::vector<Rect> queries(numQueries);
+    for (Rect& q : queries)
+    {
+        q = Rect(randPos(rng), randPos(rng), kQuerySize, kQuerySize);
+    }
+    uint64_t numCandidates = 0;
+    for (const Rect& q : queries)
+    {
+        Entity::querySlots(q, Entity::slotScratch);
+        numCandidates += Entity::slotScratch.size();
+    }
+
+    double bestPacked = 1.0e9;
+    double bestOld = 1.0e9;
+    uint64_t hitsPacked = 0;
+    uint64_t hitsOld = 0;
+    for (int round = 0; round < 3; ++round)
+    {
+        bestPacked = std::min(bestPacked, runQueries(queries, hitsPacked, Entity::queryEntities));
+        bestOld = std::min(bestOld, runQueries(queries, hitsOld, queryEntitiesOld));
+    }
+
+    printf("bench_hit_areas: entities: %zu, queries: %zu, candidates per query: %.1f, hits per query: %.1f\n",
+           numEntities, numQueries, double(numCandidates) / numQueries, double(hitsPacked) / numQueries);
+    printf("  packed areas: %.3f s, %.0f ns/query\n", bestPacked, bestPacked * 1.0e9 / numQueries);
+    printf("  entity reads: %.3f s, %.0f ns/query\n", bestOld, bestOld * 1.0e9 / numQueries);
+    printf("  speedup: %.2fx\n", bestOld / bestPacked);
+
+    for (auto& c : crowd)
+    {
+        Entity::removeEntity(c.get());
+    }
+    if (hitsPacked != hitsOld)
+    {
+        printf("bench_hit_areas: hit counts differ: %llu vs %llu\n", (unsigned long long)hitsPacked, (unsigned long long)hitsOld);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+#define SDL_MAIN_HANDLED
+#include "sprite_sheet.hpp"
+#include <SDL.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Animates and draws 5,000 sprite sheets per frame through the precomputed
+// frame table and through the old drawFrame, which split the frame index
+// with floorf and built a temporary sub-sprite for every draw. Only the CPU
+// side of submission is timed: the batch's texture is preset to the sheet's,
+// so drawQuad never flushes and GL is never touched.
+//
+// usage: bench_sprite_sheet [frames] [sheets]
+
+// SpriteSheet::drawFrame before the frame table.
+void drawFrameOld(const SpriteSheet& sheet, float dx, float dy, float radAngle = 0.0F, bool flipX = false, bool flipY = false)
+{
+    assert(sheet.frameIndex < sheet.frameMax);
+
+    uint16_t x = sheet.frameIndex % sheet.columns;
+    uint16_t y = floorf(sheet.frameIndex / float(sheet.columns));
+    float sx = sheet.frameWidth * float(x);
+    float sy = sheet.frameHeight * float(y);
+    Sprite spr;
+    spr.loadSubSprite(*sheet.source, sx, sy, sheet.frameWidth, sheet.frameHeight);
+    spr.drawSprite(dx, dy, radAngle, flipX, flipY);
+}
+
+template <typename Draw>
+double runFrames(std::vector<SpriteSheet>& sheets, SpriteBatch& batch, uint32_t numFrames, Draw draw)
+{
+    uint64_t start = SDL_GetPerformanceCounter();
+    for (uint32_t f = 0; f < numFrames; ++f)
+    {
+        batch.vertices.clear();
+        for (size_t i = 0; i < sheets.size(); ++i)
+        {
+            sheets[i].update();
+            draw(sheets[i], float(i % 100) * 8.0F, float(i / 100) * 8.0F, (i & 1) != 0);
+        }
+    }
+    return double(SDL_GetPerformanceCounter() - start) / double(SDL_GetPerformanceFrequency());
+}
+
+void resetSheets(std::vector<SpriteSheet>& sheets)
+{
+    for (size_t i = 0; i < sheets.size(); ++i)
+    {
+        sheets[i].reset();
+        // staggered so the sheets don't all show the same frame.
+        sheets[i].frameIndex = uint32_t(i % sheets[i].frameMax);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t numFrames = argc > 1 ? uint32_t(strtoul(argv[1], nullptr, 10)) : 1000;
+    size_t numSheets = argc > 2 ? size_t(strtoul(argv[2], nullptr, 10)) : 5000;
+
+    // a 4x2 sheet of 32x32 frames. never uploaded, only its size and texture id are read.
+    Sprite source;
+    source.texID = 1;
+    source.width = 128;
+    source.height = 64;
+    SpriteSheet proto;
+    proto.createSpriteSheet(source, 32, 32, 4);
+    std::vector<SpriteSheet> sheets(numSheets, proto);
+
+    SpriteBatch batch;
+    batch.texID = source.texID;
+    batch.vertices.reserve(numSheets * 6);
+    SpriteBatch::current = &batch;
+
+    double bestTable = 1.0e9;
+    double bestOld = 1.0e9;
+    std::vector<SpriteBatch::Vertex> tableVertices;
+    std::vector<SpriteBatch::Vertex> oldVertices;
+    for (int round = 0; round < 3; ++round)
+    {
+        resetSheets(sheets);
+        double t = runFrames(sheets, batch, numFrames, [](SpriteSheet& s, float x, float y, bool flipX) {
+            s.drawFrame(x, y, 0.0F, flipX);
+        });
+        bestTable = std::min(bestTable, t);
+        tableVertices = batch.vertices;
+
+        resetSheets(sheets);
+        t = runFrames(sheets, batch, numFrames, [](SpriteSheet& s, float x, float y, bool flipX) {
+            drawFrameOld(s, x, y, 0.0F, flipX);
+        });
+        bestOld = std::min(bestOld, t);
+        oldVertices = batch.vertices;
+    }
+    SpriteBatch::current = nullptr;
+
+    double numDraws = double(numFrames) * double(numSheets);
+    printf("bench_sprite_sheet: sheets: %zu, frames: %u\n", numSheets, numFrames);
+    printf("  frame table: %.3f s, %.3f ms/frame, %.1f M draws/s\n", bestTable, bestTable * 1000.0 / numFrames, numDraws / bestTable / 1.0e6);
+    printf("  old path:    %.3f s, %.3f ms/frame, %.1f M draws/s\n", bestOld, bestOld * 1000.0 / numFrames, numDraws / bestOld / 1.0e6);
+    printf("  speedup: %.2fx\n", bestOld / bestTable);
+    bool same = tableVertices.size() == oldVertices.size() &&
+                memcmp(tableVertices.data(), oldVertices.data(), tableVertices.size() * sizeof(SpriteBatch::Vertex)) == 0;
+    if (!same)
+    {
+        printf("bench_sprite_sheet: the two paths submitted different quads\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,4 @@
+#include "asset_cache.hpp"
+
+
+AssetCache* AssetCache::current = nullptr;
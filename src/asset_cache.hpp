@@ -0,0 +1,228 @@
+#pragma once
+
+#include "asset_loader.hpp"
+#include "sprite.hpp"
+#include "tilemap.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reference-counted sprites and tile maps shared by file path. The first
+// acquire loads through the AssetLoader and later ones share the same texture
+// or tile layer. The asset is unloaded when the last reference is released.
+// Each reference belongs to an owner, so releasing before the load lands also
+// drops that owner's pending onReady.
+struct AssetCache {
+    struct Waiter {
+        const void* owner = nullptr;
+        std::function<void()> onReady;
+    };
+
+    template <typename T>
+    struct Entry {
+        T asset;
+        std::string fileName;
+        uint32_t refCount = 0;
+        bool ready = false;
+        size_t bytes = 0;
+        // onReady callbacks of acquires made while the load was in flight.
+        std::vector<Waiter> waiters;
+    };
+    using SpriteEntry = Entry<Sprite>;
+    using TileMapEntry = Entry<TileMap>;
+
+    static AssetCache* current;
+
+    AssetLoader* loader = nullptr;
+    std::unordered_map<std::string, std::unique_ptr<SpriteEntry>> sprites;
+    std::unordered_map<std::string, std::unique_ptr<TileMapEntry>> tileMaps;
+    // acquired pointer to entry, for release.
+    std::unordered_map<const Sprite*, SpriteEntry*> spriteEntries;
+    std::unordered_map<const TileMap*, TileMapEntry*> tileMapEntries;
+
+    uint64_t numHits = 0;
+    uint64_t numMisses = 0;
+    size_t residentBytes = 0;
+
+    void createAssetCache(AssetLoader& assetLoader)
+    {
+        loader = &assetLoader;
+    }
+
+    // Unloads everything still resident. Destroy the loader first so no load is in flight.
+    void destroyAssetCache()
+    {
+        reportAssetCache();
+        for (auto& it : sprites)
+        {
+            if (it.second->refCount > 0)
+            {
+                printf("AssetCache: %s still has %u references\n", it.first.c_str(), it.second->refCount);
+            }
+            if (it.second->asset.isLoaded())
+            {
+                it.second->asset.unloadSprite();
+            }
+        }
+        for (auto& it : tileMaps)
+        {
+            if (it.second->refCount > 0)
+            {
+                printf("AssetCache: %s still has %u references\n", it.first.c_str(), it.second->refCount);
+            }
+            if (it.second->asset.tileLayer)
+            {
+                it.second->asset.unloadTileMap();
+            }
+        }
+        sprites.clear();
+        tileMaps.clear();
+        spriteEntries.clear();
+        tileMapEntries.clear();
+        residentBytes = 0;
+        if (current == this)
+        {
+            current = nullptr;
+        }
+    }
+
+    // The returned sprite is shared and stays at the same address until released.
+    // onReady runs on the main thread once it is uploaded, right away on a cache hit.
+    // Pass the same owner to releaseSprite so an onReady still pending is dropped.
+    Sprite* acquireSprite(const char* fileName, const void* owner, std::function<void()> onReady = nullptr)
+    {
+        return acquire(sprites, spriteEntries, fileName, owner, std::move(onReady), [this](SpriteEntry* e) {
+            return loader->loadSpriteAsync(&e->asset, e->fileName.c_str(), [this, e]() {
+                onLoaded(*e, size_t(e->asset.width) * e->asset.height * 4);
+                if (e->refCount == 0)
+                {
+                    releaseSprite(&e->asset, nullptr);
+                }
+            });
+        });
+    }
+
+    TileMap* acquireTileMap(const char* fileName, const void* owner, std::function<void()> onReady = nullptr)
+    {
+        return acquire(tileMaps, tileMapEntries, fileName, owner, std::move(onReady), [this](TileMapEntry* e) {
+            return loader->loadTileMapAsync(&e->asset, e->fileName.c_str(), [this, e]() {
+                onLoaded(*e, size_t(e->asset.width) * e->asset.height);
+                if (e->refCount == 0)
+                {
+                    releaseTileMap(&e->asset, nullptr);
+                }
+            });
+        });
+    }
+
+    void releaseSprite(const Sprite* sprite, const void* owner)
+    {
+        release(sprites, spriteEntries, sprite, owner, [](Sprite& s) { s.unloadSprite(); });
+    }
+
+    void releaseTileMap(const TileMap* map, const void* owner)
+    {
+        release(tileMaps, tileMapEntries, map, owner, [](TileMap& m) { m.unloadTileMap(); });
+    }
+
+    void reportAssetCache() const
+    {
+        printf("AssetCache: sprites: %zu, tile maps: %zu, hits: %llu, misses: %llu, resident: %zu bytes\n",
+               sprites.size(), tileMaps.size(), (unsigned long long)numHits, (unsigned long long)numMisses, residentBytes);
+    }
+
+    template <typename T, typename Load>
+    T* acquire(std::unordered_map<std::string, std::unique_ptr<Entry<T>>>& entries, std::unordered_map<const T*, Entry<T>*>& byAsset,
+               const char* fileName, const void* owner, std::function<void()> onReady, Load load)
+    {
+        assert(loader);
+        // without an owner a pending onReady could never be dropped again.
+        assert(owner || !onReady);
+        auto it = entries.find(fileName);
+        if (it != entries.end())
+        {
+            Entry<T>* e = it->second.get();
+            numHits++;
+            e->refCount++;
+            if (onReady)
+            {
+                if (e->ready)
+                {
+                    onReady();
+                }
+                else
+                {
+                    e->waiters.push_back({owner, std::move(onReady)});
+                }
+            }
+            return &e->asset;
+        }
+
+        numMisses++;
+        Entry<T>* e = new Entry<T>();
+        entries.emplace(fileName, std::unique_ptr<Entry<T>>(e));
+        byAsset[&e->asset] = e;
+        e->fileName = fileName;
+        e->refCount = 1;
+        if (onReady)
+        {
+            e->waiters.push_back({owner, std::move(onReady)});
+        }
+        load(e);
+        return &e->asset;
+    }
+
+    // Waiters run before the entry is marked ready, so a release from inside one
+    // only drops its reference and the load callback unloads the entry afterwards.
+    template <typename T>
+    void onLoaded(Entry<T>& e, size_t bytes)
+    {
+        e.bytes = bytes;
+        residentBytes += bytes;
+        while (!e.waiters.empty())
+        {
+            Waiter w = std::move(e.waiters.front());
+            e.waiters.erase(e.waiters.begin());
+            w.onReady();
+        }
+        e.ready = true;
+    }
+
+    template <typename T, typename Unload>
+    void release(std::unordered_map<std::string, std::unique_ptr<Entry<T>>>& entries, std::unordered_map<const T*, Entry<T>*>& byAsset,
+                 const T* asset, const void* owner, Unload unload)
+    {
+        auto it = byAsset.find(asset);
+        assert(it != byAsset.end());
+        Entry<T>* e = it->second;
+        if (e->refCount > 0)
+        {
+            e->refCount--;
+        }
+        if (owner)
+        {
+            // one waiter per acquire, so drop one of this owner's.
+            auto waiter = std::find_if(e->waiters.begin(), e->waiters.end(), [owner](const Waiter& w) { return w.owner == owner; });
+            if (waiter != e->waiters.end())
+            {
+                e->waiters.erase(waiter);
+            }
+        }
+        if (e->refCount > 0 || !e->ready)
+        {
+            // an in-flight load is released again when it lands.
+            return;
+        }
+        unload(e->asset);
+        residentBytes -= e->bytes;
+        byAsset.erase(it);
+        std::string fileName = e->fileName;
+        entries.erase(fileName);
+    }
+};
@@ -0,0 +1,4 @@
+#include "asset_loader.hpp"
+
+
+AssetLoader* AssetLoader::current = nullptr;
@@ -0,0 +1,326 @@
+#pragma once
+
+#include "sprite.hpp"
+#include "tilemap.hpp"
+#include "asset_pack.hpp"
+#include "thread_pool.hpp"
+#include "profiler.hpp"
+#include <SDL.h>
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Refers to a load request. Request slots are recycled once they finish, and the
+// generation changes each time, so a handle to a finished request stays ready
+// instead of aliasing the load that reused its slot.
+struct AssetHandle {
+    uint32_t index = 0;
+    // 0 is never issued, so a default handle is invalid.
+    uint32_t generation = 0;
+
+    bool isValid() const
+    {
+        return generation != 0;
+    }
+};
+
+enum AssetKind {
+    kAssetKindSprite = 0,
+    kAssetKindTileMap,
+};
+
+// Decodes PNGs and parses maps on worker threads. Finished requests queue up
+// for the main thread, where update() uploads them to GL within a time budget.
+struct AssetLoader {
+    struct Request {
+        AssetKind kind = kAssetKindSprite;
+        std::string fileName;
+        Sprite* sprite = nullptr;
+        TileMap* tileMap = nullptr;
+        SpriteImage image;
+        // decompressed AssetPack entry. kept until the request finishes.
+        std::vector<uint8_t> buffer;
+        // main thread, once the asset is usable.
+        std::function<void()> onReady;
+        uint32_t index = 0;
+        // bumped when the request finishes and its slot is freed.
+        uint32_t generation = 1;
+    };
+
+    static AssetLoader* current;
+
+    ThreadPool pool;
+    // request slots. pointers stay put while workers hold them.
+    std::vector<std::unique_ptr<Request>> requests;
+    std::vector<uint32_t> freeRequests;
+    uint32_t numPending = 0;
+    // requests finished since creation.
+    size_t numLoaded = 0;
+
+    // decoded by a worker and waiting for update().
+    std::mutex mutex;
+    std::condition_variable decodedCV;
+    std::deque<Request*> decoded;
+
+    uint64_t firstRequestTime = 0;
+    uint64_t uploadTicks = 0;
+
+    void createAssetLoader(uint32_t numThreads = 0)
+    {
+        pool.createThreadPool(numThreads);
+    }
+
+    void destroyAssetLoader()
+    {
+        assert(pool.isCreated());
+        pool.destroyThreadPool();
+        for (Request* r : decoded)
+        {
+            if (r->image.pixels)
+            {
+                Sprite::freeSpriteImage(r->image);
+            }
+        }
+        decoded.clear();
+        requests.clear();
+        freeRequests.clear();
+        numPending = 0;
+        numLoaded = 0;
+        if (current == this)
+        {
+            current = nullptr;
+        }
+    }
+
+    // dst must stay put until the handle is ready. onReady runs on the main thread after the upload.
+    AssetHandle loadSpriteAsync(Sprite* dst, const char* fileName, std::function<void()> onReady = nullptr)
+    {
+        assert(dst && !dst->isLoaded());
+        Request* r = addRequest(kAssetKindSprite, fileName, std::move(onReady));
+        r->sprite = dst;
+        submit(r);
+        return {r->index, r->generation};
+    }
+
+    // Parses on a worker. No GL involved, so the map is ready as soon as update() sees it.
+    AssetHandle loadTileMapAsync(TileMap* dst, const char* fileName, std::function<void()> onReady = nullptr)
+    {
+        assert(dst && !dst->tileLayer);
+        Request* r = addRequest(kAssetKindTileMap, fileName, std::move(onReady));
+        r->tileMap = dst;
+        submit(r);
+        return {r->index, r->generation};
+    }
+
+    // Blocking batch load. Decodes every file in parallel on the workers, then
+    // uploads them all in one pass on the calling thread, which must own the GL context.
+    void loadSprites(Sprite* const* sprites, const char* const* fileNames, size_t count)
+    {
+        PROFILE_SCOPE("AssetLoader::loadSprites");
+        assert(pool.isCreated());
+        std::vector<SpriteImage> images(count);
+        std::vector<std::vector<uint8_t>> buffers(count);
+        std::mutex doneMutex;
+        std::condition_variable doneCV;
+        size_t numDone = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            assert(!sprites[i]->isLoaded());
+            pool.submit([&, i]() {
+                images[i] = decodeSpriteFile(fileNames[i], buffers[i]);
+                std::lock_guard<std::mutex> lock(doneMutex);
+                numDone++;
+                doneCV.notify_one();
+            });
+        }
+        {
+            std::unique_lock<std::mutex> lock(doneMutex);
+            doneCV.wait(lock, [&]() { return numDone == count; });
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            sprites[i]->uploadSprite(images[i]);
+            Sprite::freeSpriteImage(images[i]);
+        }
+    }
+
+    bool isReady(AssetHandle handle) const
+    {
+        assert(handle.isValid() && handle.index < requests.size());
+        return requests[handle.index]->generation != handle.generation;
+    }
+
+    bool isIdle() const
+    {
+        return numPending == 0;
+    }
+
+    // Blocks until handle is ready, finishing whatever else completes meanwhile.
+    void wait(AssetHandle handle)
+    {
+        PROFILE_SCOPE("AssetLoader::wait");
+        while (!isReady(handle))
+        {
+            waitForDecoded();
+            update(1.0e9);
+        }
+    }
+
+    void waitAll()
+    {
+        PROFILE_SCOPE("AssetLoader::waitAll");
+        while (!isIdle())
+        {
+            waitForDecoded();
+            update(1.0e9);
+        }
+    }
+
+    // Main thread, once per frame. Finishes decoded requests until budget
+    // seconds have passed, but always at least one so loading can't stall.
+    void update(double budget)
+    {
+        PROFILE_SCOPE("AssetLoader::update");
+        uint64_t freq = SDL_GetPerformanceFrequency();
+        uint64_t startTime = SDL_GetPerformanceCounter();
+        uint64_t budgetTicks = uint64_t(budget * double(freq));
+        while (numPending > 0)
+        {
+            Request* r = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (decoded.empty())
+                {
+                    break;
+                }
+                r = decoded.front();
+                decoded.pop_front();
+            }
+            finishRequest(*r);
+            if (SDL_GetPerformanceCounter() - startTime >= budgetTicks)
+            {
+                break;
+            }
+        }
+        uploadTicks += SDL_GetPerformanceCounter() - startTime;
+
+        if (numPending == 0 && firstRequestTime != 0)
+        {
+            printf("AssetLoader: loaded: %zu, wall time: %.3f ms, main thread time: %.3f ms\n",
+                   numLoaded, double(SDL_GetPerformanceCounter() - firstRequestTime) * 1000.0 / freq, double(uploadTicks) * 1000.0 / freq);
+            firstRequestTime = 0;
+            uploadTicks = 0;
+        }
+    }
+
+    Request* addRequest(AssetKind kind, const char* fileName, std::function<void()> onReady)
+    {
+        assert(pool.isCreated());
+        Request* r;
+        if (!freeRequests.empty())
+        {
+            r = requests[freeRequests.back()].get();
+            freeRequests.pop_back();
+        }
+        else
+        {
+            requests.push_back(std::make_unique<Request>());
+            r = requests.back().get();
+            r->index = uint32_t(requests.size() - 1);
+        }
+        r->kind = kind;
+        r->fileName = fileName;
+        r->onReady = std::move(onReady);
+        return r;
+    }
+
+    void submit(Request* r)
+    {
+        if (numPending == 0 && firstRequestTime == 0)
+        {
+            firstRequestTime = SDL_GetPerformanceCounter();
+        }
+        numPending++;
+        pool.submit([this, r]() {
+            decodeRequest(*r);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                decoded.push_back(r);
+            }
+            decodedCV.notify_all();
+        });
+    }
+
+    void waitForDecoded()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        decodedCV.wait(lock, [this]() { return !decoded.empty(); });
+    }
+
+    // worker thread. reads from AssetPack::current when it has the file.
+    static SpriteImage decodeSpriteFile(const char* fileName, std::vector<uint8_t>& buffer)
+    {
+        ByteSpan packed;
+        if (AssetPack::current && AssetPack::current->getEntry(fileName, packed, buffer))
+        {
+            return Sprite::decodeSpriteFromMemory(packed, fileName, TextureCache::getAssetRoot(AssetPack::current->path.c_str()));
+        }
+        return Sprite::decodeSprite(fileName);
+    }
+
+    // worker thread. must not touch GL.
+    static void decodeRequest(Request& r)
+    {
+        ByteSpan packed;
+        switch (r.kind)
+        {
+        case kAssetKindSprite:
+            r.image = decodeSpriteFile(r.fileName.c_str(), r.buffer);
+            break;
+        case kAssetKindTileMap:
+            if (AssetPack::current && AssetPack::current->getEntry(r.fileName.c_str(), packed, r.buffer))
+            {
+                r.tileMap->loadTileMapFromMemory(packed, r.fileName.c_str());
+            }
+            else
+            {
+                r.tileMap->loadTileMap(r.fileName.c_str());
+            }
+            break;
+        }
+    }
+
+    // main thread. frees the slot before onReady, so onReady may start new loads.
+    void finishRequest(Request& r)
+    {
+        if (r.kind == kAssetKindSprite)
+        {
+            r.sprite->uploadSprite(r.image);
+            Sprite::freeSpriteImage(r.image);
+        }
+        std::function<void()> onReady = std::move(r.onReady);
+        r.onReady = nullptr;
+        r.sprite = nullptr;
+        r.tileMap = nullptr;
+        r.buffer = std::vector<uint8_t>();
+        if (++r.generation == 0)
+        {
+            r.generation = 1;
+        }
+        freeRequests.push_back(r.index);
+        numPending--;
+        numLoaded++;
+        if (onReady)
+        {
+            onReady();
+        }
+    }
+};
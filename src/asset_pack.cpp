@@ -0,0 +1,173 @@
+#include "asset_pack.hpp"
+#include "lz4_block.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+AssetPack* AssetPack::current = nullptr;
+
+bool AssetPack::openAssetPack(const char* fileName)
+{
+    assert(!mapped.isOpen());
+    if (!mapped.openMappedFile(fileName))
+    {
+        printf("openAssetPack: failed to open %s\n", fileName);
+        return false;
+    }
+    header = (const AssetPackHeader*)mapped.data;
+    bool valid = mapped.size >= sizeof(AssetPackHeader) && memcmp(header->magic, "HNPK", 4) == 0 && header->version == AssetPackHeader::kVersion &&
+                 header->indexOffset <= mapped.size && uint64_t(header->numEntries) * sizeof(AssetPackEntry) <= mapped.size - header->indexOffset;
+    if (!valid)
+    {
+        printf("openAssetPack: %s is not an asset pack\n", fileName);
+        closeAssetPack();
+        return false;
+    }
+    entries = (const AssetPackEntry*)(mapped.data + header->indexOffset);
+    path = fileName;
+    names = (const char*)(entries + header->numEntries);
+    printf("openAssetPack: %s, entries: %u, size: %zu\n", fileName, header->numEntries, mapped.size);
+    return true;
+}
+
+void AssetPack::closeAssetPack()
+{
+    mapped.closeMappedFile();
+    path.clear();
+    header = nullptr;
+    entries = nullptr;
+    names = nullptr;
+    if (current == this)
+    {
+        current = nullptr;
+    }
+}
+
+const AssetPackEntry* AssetPack::findEntry(const char* name) const
+{
+    if (!header)
+    {
+        return nullptr;
+    }
+    const AssetPackEntry* end = entries + header->numEntries;
+    const AssetPackEntry* it = std::lower_bound(entries, end, name, [this](const AssetPackEntry& e, const char* key) {
+        return strcmp(names + e.nameOffset, key) < 0;
+    });
+    if (it == end || strcmp(names + it->nameOffset, name) != 0)
+    {
+        return nullptr;
+    }
+    return it;
+}
+
+bool AssetPack::getEntry(const char* name, ByteSpan& out, std::vector<uint8_t>& buffer) const
+{
+    const AssetPackEntry* e = findEntry(name);
+    if (!e)
+    {
+        return false;
+    }
+    assert(e->offset + e->size <= mapped.size);
+    const uint8_t* data = mapped.data + e->offset;
+    if (e->flags & AssetPackEntry::kFlagLZ4)
+    {
+        buffer.resize(size_t(e->rawSize));
+        bool ok = lz4Decompress(data, size_t(e->size), buffer.data(), buffer.size());
+        assert(ok);
+        (void)ok;
+        out.data = buffer.data();
+        out.size = buffer.size();
+    }
+    else
+    {
+        out.data = data;
+        out.size = size_t(e->size);
+    }
+    return true;
+}
+
+bool AssetPack::writeAssetPack(const char* fileName, const char* const* fileNames, size_t numFiles, bool compress)
+{
+    std::vector<size_t> order(numFiles);
+    for (size_t i = 0; i < numFiles; ++i)
+    {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return strcmp(fileNames[a], fileNames[b]) < 0; });
+
+    FILE* fp = fopen(fileName, "wb");
+    if (!fp)
+    {
+        printf("writeAssetPack: failed to open %s\n", fileName);
+        return false;
+    }
+    AssetPackHeader header = {};
+    fwrite(&header, sizeof(header), 1, fp);
+
+    static const uint8_t padding[16] = {0};
+    uint64_t offset = sizeof(header);
+    std::vector<AssetPackEntry> index;
+    std::string nameTable;
+    uint64_t totalRaw = 0;
+    for (size_t i : order)
+    {
+        MappedFile src;
+        if (!src.openMappedFile(fileNames[i]))
+        {
+            printf("writeAssetPack: failed to open %s\n", fileNames[i]);
+            fclose(fp);
+            return false;
+        }
+        size_t pad = size_t((16 - offset % 16) % 16);
+        fwrite(padding, 1, pad, fp);
+        offset += pad;
+
+        AssetPackEntry e = {};
+        e.nameOffset = uint32_t(nameTable.size());
+        e.offset = offset;
+        e.rawSize = src.size;
+        std::vector<uint8_t> packed;
+        if (compress)
+        {
+            packed = lz4Compress(src.data, src.size);
+        }
+        if (compress && packed.size() < src.size)
+        {
+            e.flags = AssetPackEntry::kFlagLZ4;
+            e.size = packed.size();
+            fwrite(packed.data(), 1, packed.size(), fp);
+        }
+        else
+        {
+            e.size = src.size;
+            fwrite(src.data, 1, src.size, fp);
+        }
+        printf("writeAssetPack: %s, %llu -> %llu bytes%s\n", fileNames[i], (unsigned long long)e.rawSize, (unsigned long long)e.size,
+               e.flags & AssetPackEntry::kFlagLZ4 ? " (lz4)" : "");
+        offset += e.size;
+        totalRaw += e.rawSize;
+        nameTable.append(fileNames[i]);
+        nameTable.push_back('\0');
+        index.push_back(e);
+        src.closeMappedFile();
+    }
+
+    size_t pad = size_t((16 - offset % 16) % 16);
+    fwrite(padding, 1, pad, fp);
+    offset += pad;
+    fwrite(index.data(), sizeof(AssetPackEntry), index.size(), fp);
+    fwrite(nameTable.data(), 1, nameTable.size(), fp);
+
+    memcpy(header.magic, "HNPK", 4);
+    header.version = AssetPackHeader::kVersion;
+    header.numEntries = uint32_t(index.size());
+    header.indexOffset = offset;
+    fseek(fp, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, fp);
+    bool ok = fclose(fp) == 0;
+    printf("writeAssetPack: %s, entries: %zu, raw: %llu bytes, packed: %llu bytes\n", fileName, index.size(), (unsigned long long)totalRaw,
+           (unsigned long long)(offset + index.size() * sizeof(AssetPackEntry) + nameTable.size()));
+    return ok;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "byte_span.hpp"
+#include "mapped_file.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One archive of assets, mapped as a whole so loading an entry needs no file open.
+// Little-endian layout:
+//   header: "HNPK", uint32 version, uint32 numEntries, uint32 reserved, uint64 indexOffset
+//   entry data, each 16-byte aligned
+//   index: numEntries AssetPackEntry sorted by name, then the NUL-terminated names
+struct AssetPackEntry {
+    static constexpr uint32_t kFlagLZ4 = 1;
+
+    uint32_t nameOffset;
+    uint32_t flags;
+    uint64_t offset;
+    // bytes stored in the pack and bytes after decompression.
+    uint64_t size;
+    uint64_t rawSize;
+};
+
+struct AssetPackHeader {
+    static constexpr uint32_t kVersion = 2;
+
+    char magic[4];
+    uint32_t version;
+    uint32_t numEntries;
+    uint32_t reserved;
+    uint64_t indexOffset;
+};
+static_assert(sizeof(AssetPackHeader) == 24, "AssetPackHeader has no implicit padding");
+
+struct AssetPack {
+    static AssetPack* current;
+
+    MappedFile mapped;
+    std::string path;
+    const AssetPackHeader* header = nullptr;
+    const AssetPackEntry* entries = nullptr;
+    const char* names = nullptr;
+
+    bool openAssetPack(const char* fileName);
+    void closeAssetPack();
+
+    const AssetPackEntry* findEntry(const char* name) const;
+
+    // Stored entries are returned in place. Compressed ones are decompressed
+    // into buffer, which must outlive the returned span. false if name is missing.
+    bool getEntry(const char* name, ByteSpan& out, std::vector<uint8_t>& buffer) const;
+
+    // Packs fileNames under their given names. compress tries LZ4 per entry
+    // and keeps it only where it saves space.
+    static bool writeAssetPack(const char* fileName, const char* const* fileNames, size_t numFiles, bool compress);
+};
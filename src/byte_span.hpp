@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Non-owning view of bytes in memory, e.g. an asset inside a mapped pack.
+struct ByteSpan {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
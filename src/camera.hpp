@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gmath.hpp"
+#include "rect.hpp"
 
 struct Camera {
     Vector3 position = vec3(0.0F, 0.0F, 1.0F);
@@ -16,4 +17,14 @@ struct Camera {
         Matrix4 view = mat4LookAt(position, vec3(position.x, position.y, -1.0F), vec3(0.0F, 1.0F, 0.0));
         return mat4Multiply(view, proj);
     }
+
+    // World-space area covered by an orthographic projection.
+    Rect getVisibleRect() const
+    {
+        float left = (-1.0F - proj.m41) / proj.m11;
+        float right = (1.0F - proj.m41) / proj.m11;
+        float bottom = (-1.0F - proj.m42) / proj.m22;
+        float top = (1.0F - proj.m42) / proj.m22;
+        return {position.x + left, position.y + bottom, right - left, top - bottom};
+    }
 };
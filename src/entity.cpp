@@ -1,6 +1,14 @@
 #include "entity.hpp"
 
 
-std::vector<Entity*> Entity::entities;
+EntityRegistry Entity::registry;
 
-uint64_t Entity::uid = 0;
+SpatialGrid Entity::grid;
+
+std::vector<uint32_t> Entity::slotScratch;
+
+std::vector<Entity*> Entity::queryScratch;
+
+std::vector<Contact> Entity::contactStack;
+
+const TileCollider* Entity::tileCollider = nullptr;
@@ -1,156 +1,292 @@
 #pragma once
 
 #include "gmath.hpp"
+#include "rect.hpp"
+#include "spatial_grid.hpp"
+#include "entity_registry.hpp"
+#include "tile_collider.hpp"
+#include "profiler.hpp"
 #include "glad.h"
 #include <vector>
-#include <functional>
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <type_traits>
 
-struct Rect {
-    float x, y, w, h;
+struct Entity;
 
-    Rect()
-    {
-        x = 0.0F;
-        y = 0.0F;
-        w = 0.0F;
-        h = 0.0F;
-    }
+// What a mover ran into. entity is nullptr for solid tiles.
+struct Contact {
+    Entity* entity = nullptr;
+    Rect area;
+    // fraction of the move travelled before touching area. 0 if already overlapping.
+    float time = 0.0F;
+    Vector3 normal = vec3Zero();
+};
 
-    Rect(float x, float y, float w, float h) : x(x), y(y), w(w), h(h) {}
+// Keeps a literal nullptr or a Contact* from binding to the templated moveX/moveY
+// instead of the overloads that take hit.
+template <typename F>
+using IsCollideCallback = std::enable_if_t<!std::is_pointer_v<std::decay_t<F>> && !std::is_null_pointer_v<std::decay_t<F>>>;
+
+struct Entity {
+    static EntityRegistry registry;
+    static SpatialGrid grid;
+    // scratch storage reused across moves so collision queries don't allocate.
+    // contactStack grows and shrinks like a stack so onCollide may move other entities.
+    static std::vector<uint32_t> slotScratch;
+    static std::vector<Entity*> queryScratch;
+    static std::vector<Contact> contactStack;
+    static const TileCollider* tileCollider;
 
-    bool isHit(const Rect& other)
+    static void addEntity(Entity* e)
     {
-        return (x + w > other.x &&
-                y + h > other.y &&
-                x < other.x + other.w &&
-                y < other.y + other.h);
+        assert(!registry.contains(e->handle));
+        e->handle = registry.add(e);
+        Rect area = e->getHitArea();
+        registry.setArea(e->handle.index, area);
+        e->gridRange = grid.computeRange(area);
+        grid.insert(e->handle.index, e->gridRange);
     }
-};
 
-struct Entity {
-    static std::vector<Entity*> entities;
-    static uint64_t uid;
+    // Aborts if e is not registered, such as when it was already removed.
+    static void removeEntity(Entity* e)
+    {
+        if (registry.get(e->handle) != e)
+        {
+            abort();
+        }
+        grid.remove(e->handle.index, e->gridRange);
+        registry.remove(e->handle);
+    }
 
-    static uint64_t genID()
+    // nullptr if the entity behind handle has been removed.
+    static Entity* getEntity(EntityHandle handle)
     {
-        return ++uid;
+        return registry.get(handle);
     }
 
-    static void addEntity(Entity* e)
+    // Refreshes every stored hit area in one linear pass over the registry, picking
+    // up positions written outside of moveX and moveY. Run once at the start of a tick.
+    static void syncAreas()
     {
-        assert(e->id);
-        entities.push_back(e);
+        PROFILE_SCOPE("Entity::syncAreas");
+        for (Entity* e : registry)
+        {
+            e->syncArea();
+        }
     }
 
-    static void removeEntity(Entity* e)
+    // Slots whose grid cells touch area, sorted with duplicates removed.
+    static void querySlots(const Rect& area, std::vector<uint32_t>& out)
     {
-        assert(e->id);
+        out.clear();
+        grid.query(area, out);
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
 
-        for (size_t i = 0; i < entities.size(); ++i)
+    // Entities whose stored hit area overlaps area, sorted by handle index.
+    static void queryEntities(const Rect& area, std::vector<Entity*>& out)
+    {
+        querySlots(area, slotScratch);
+        out.clear();
+        for (uint32_t slot : slotScratch)
         {
-            if (e->id == entities[i]->id)
+            if (area.isHit(registry.getArea(slot)))
             {
-                entities[i] = entities.back();
-                entities.pop_back();
-                return;
+                out.push_back(registry.getAt(slot));
             }
         }
-        abort();
     }
 
-    uint64_t id = 0;
+    // set by addEntity. stays stale after removeEntity.
+    EntityHandle handle;
     Vector3 position = vec3Zero();
+    // position at the start of the current fixed tick, for render interpolation.
+    Vector3 prevPosition = vec3Zero();
     Rect hitbox;
+    GridRange gridRange;
 
     ~Entity()
     {
-        assert(id);
+        assert(handle.isValid());
     }
 
     virtual void onPreload() {}
+    virtual void onUnload() {}
+
+    void savePrevPosition()
+    {
+        prevPosition = position;
+    }
+
+    // alpha is how far rendering is between the previous and the current tick.
+    Vector3 getRenderPosition(float alpha) const
+    {
+        return vec3Lerp(prevPosition, position, alpha);
+    }
 
     Rect getHitArea()
     {
         return {hitbox.x + position.x, hitbox.y + position.y, hitbox.w, hitbox.h};
     }
 
-    bool moveX(float x, std::function<bool(Entity*)> onCollide = [](Entity*) { return true; }, float step = 1.0F)
+    // Stores the current hit area in the registry and re-buckets the entity if it
+    // moved. Cheap when it stays within the same cells.
+    void syncArea()
     {
-        float total = 0.0F;
-        float sign = x > 0.0 ? 1.0F : -1.0F;
+        Rect area = getHitArea();
+        registry.setArea(handle.index, area);
+        GridRange range = grid.computeRange(area);
+        if (range != gridRange)
+        {
+            grid.remove(handle.index, gridRange);
+            grid.insert(handle.index, range);
+            gridRange = range;
+        }
+    }
 
-        for (bool finished = false; !finished;)
+    // Sweeps the hit area d pixels along one axis in a single pass. Contacts are
+    // visited in time-of-impact order and the mover is placed flush against each
+    // one before onCollide decides whether it stops the move.
+    template <typename OnCollide>
+    bool sweep(float d, bool horizontal, OnCollide&& onCollide, Contact* hit)
+    {
+        Rect from = getHitArea();
+        float sign = d > 0.0F ? 1.0F : -1.0F;
+        Rect swept = from;
+        if (horizontal)
         {
-            float mx = sign * step;
-            if (fabs(total + sign * step) > fabs(x))
+            swept.x += fminf(d, 0.0F);
+            swept.w += fabsf(d);
+        }
+        else
+        {
+            swept.y += fminf(d, 0.0F);
+            swept.h += fabsf(d);
+        }
+
+        size_t base = contactStack.size();
+        auto addContact = [&](Entity* e, const Rect& area) {
+            float gap = 0.0F;
+            if (horizontal)
             {
-                mx = (fabs(x) - fabs(total)) * sign;
-                finished = true;
+                gap = sign > 0.0F ? area.x - (from.x + from.w) : from.x - (area.x + area.w);
             }
-
-            for (Entity* e : Entity::entities)
+            else
             {
-                if (id == e->id)
-                {
-                    continue;
-                }
-                Rect hurtbox = Rect(hitbox.x + position.x + mx, hitbox.y + position.y, hitbox.w, hitbox.h);
-                if (hurtbox.isHit(e->getHitArea()) && onCollide(e))
-                {
-                    return true;
-                }
+                gap = sign > 0.0F ? area.y - (from.y + from.h) : from.y - (area.y + area.h);
             }
+            Contact c;
+            c.entity = e;
+            c.area = area;
+            c.time = fabsf(d) > 0.0F ? std::clamp(gap / fabsf(d), 0.0F, 1.0F) : 0.0F;
+            c.normal = horizontal ? vec3(-sign, 0.0F, 0.0F) : vec3(0.0F, -sign, 0.0F);
+            contactStack.push_back(c);
+        };
 
-            position.x += mx;
-            total += mx;
+        querySlots(swept, slotScratch);
+        for (uint32_t slot : slotScratch)
+        {
+            if (slot != handle.index && swept.isHit(registry.getArea(slot)))
+            {
+                addContact(registry.getAt(slot), registry.getArea(slot));
+            }
         }
-
-        return false;
-    }
-
-    bool moveY(float y, std::function<bool(Entity*)> onCollide = [](Entity*) { return true; }, float step = 1.0F)
-    {
-        float total = 0.0F;
-        float sign = y > 0.0 ? 1.0F : -1.0F;
-
-        for (bool finished = false; !finished;)
+        if (tileCollider)
+        {
+            tileCollider->forEachSolid(swept, [&](const Rect& r) {
+                addContact(nullptr, r);
+                return false;
+            });
+        }
+        // stable insertion sort. there are only a handful of contacts and it doesn't allocate.
+        size_t end = contactStack.size();
+        for (size_t i = base + 1; i < end; ++i)
         {
-            float my = sign * step;
-            if (fabs(total + sign * step) > fabs(y))
+            Contact c = contactStack[i];
+            size_t j = i;
+            for (; j > base && contactStack[j - 1].time > c.time; --j)
             {
-                my = (fabs(y) - fabs(total)) * sign;
-                finished = true;
+                contactStack[j] = contactStack[j - 1];
             }
+            contactStack[j] = c;
+        }
 
-            for (Entity* e : Entity::entities)
+        float start = horizontal ? position.x : position.y;
+        for (size_t i = base; i < end; ++i)
+        {
+            // copied since onCollide may push to contactStack and reallocate it.
+            Contact c = contactStack[i];
+            if (c.time > 0.0F)
             {
-                if (id == e->id)
+                if (horizontal)
                 {
-                    continue;
+                    position.x = sign > 0.0F ? c.area.x - hitbox.x - hitbox.w : c.area.x + c.area.w - hitbox.x;
                 }
-                Rect hurtbox = Rect(hitbox.x + position.x, hitbox.y + position.y + my, hitbox.w, hitbox.h);
-                if (hurtbox.isHit(e->getHitArea()) && onCollide(e))
+                else
                 {
-                    return true;
+                    position.y = sign > 0.0F ? c.area.y - hitbox.y - hitbox.h : c.area.y + c.area.h - hitbox.y;
                 }
             }
-
-            position.y += my;
-            total += my;
+            if (onCollide(c))
+            {
+                if (hit)
+                {
+                    *hit = c;
+                }
+                contactStack.resize(base);
+                syncArea();
+                return true;
+            }
         }
 
+        if (horizontal)
+        {
+            position.x = start + d;
+        }
+        else
+        {
+            position.y = start + d;
+        }
+        contactStack.resize(base);
+        syncArea();
         return false;
     }
+
+    template <typename OnCollide, typename = IsCollideCallback<OnCollide>>
+    bool moveX(float x, OnCollide&& onCollide, Contact* hit = nullptr)
+    {
+        PROFILE_SCOPE("Entity::moveX");
+        return sweep(x, true, onCollide, hit);
+    }
+
+    bool moveX(float x, Contact* hit = nullptr)
+    {
+        return moveX(x, [](const Contact&) { return true; }, hit);
+    }
+
+    template <typename OnCollide, typename = IsCollideCallback<OnCollide>>
+    bool moveY(float y, OnCollide&& onCollide, Contact* hit = nullptr)
+    {
+        PROFILE_SCOPE("Entity::moveY");
+        return sweep(y, false, onCollide, hit);
+    }
+
+    bool moveY(float y, Contact* hit = nullptr)
+    {
+        return moveY(y, [](const Contact&) { return true; }, hit);
+    }
 };
 
-inline void drawHitbox(const Entity& e, float r = 1.0F, float g = 1.0F, float b = 1.0F, float a = 1.0F)
+inline void drawRect(const Rect& rect, float r = 1.0F, float g = 1.0F, float b = 1.0F, float a = 1.0F)
 {
-    float x = floorf(e.position.x) + floorf(e.hitbox.x) + 0.5F;
-    float y = floorf(e.position.y) + floorf(e.hitbox.y) + 0.5F;
-    float w = floorf(e.hitbox.w) - 1.0F;
-    float h = floorf(e.hitbox.h) - 1.0F;
+    float x = floorf(rect.x) + 0.5F;
+    float y = floorf(rect.y) + 0.5F;
+    float w = floorf(rect.w) - 1.0F;
+    float h = floorf(rect.h) - 1.0F;
     glBegin(GL_LINES);
     glColor4f(r, g, b, a);
     glVertex3f(x, y, 0.0F);
@@ -166,3 +302,8 @@ inline void drawHitbox(const Entity& e, float r = 1.0F, float g = 1.0F, float b
     glColor4f(1.0F, 1.0F, 1.0F, 1.0F);
     glEnd();
 }
+
+inline void drawHitbox(const Entity& e, float r = 1.0F, float g = 1.0F, float b = 1.0F, float a = 1.0F)
+{
+    drawRect(Rect(floorf(e.position.x) + floorf(e.hitbox.x), floorf(e.position.y) + floorf(e.hitbox.y), e.hitbox.w, e.hitbox.h), r, g, b, a);
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "rect.hpp"
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+struct Entity;
+
+// Refers to a registered entity without owning it. The generation changes
+// every time a slot is reused, so a handle to a removed entity stays detectably
+// stale instead of aliasing whatever moved into its slot.
+struct EntityHandle {
+    uint32_t index = 0;
+    // 0 is never issued, so a default handle is invalid.
+    uint32_t generation = 0;
+
+    bool isValid() const
+    {
+        return generation != 0;
+    }
+
+    bool operator==(const EntityHandle& rhs) const
+    {
+        return index == rhs.index && generation == rhs.generation;
+    }
+
+    bool operator!=(const EntityHandle& rhs) const
+    {
+        return !(*this == rhs);
+    }
+};
+
+// Sparse set of entities. slots is indexed by handle and points into the packed
+// dense array, so add, remove and lookup are O(1) and iteration is a linear scan.
+// World-space hit areas are kept alongside in a packed component array indexed by
+// slot, so the broadphase can test candidates without touching the entities.
+struct EntityRegistry {
+    static constexpr uint32_t kNoDense = UINT32_MAX;
+
+    struct Slot {
+        uint32_t generation = 0;
+        uint32_t dense = kNoDense;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::vector<Entity*> dense;
+    // slot index of each dense element, to fix up the moved element on removal.
+    std::vector<uint32_t> denseSlots;
+    // hit area of the entity in each slot. indexed by slot rather than dense so the
+    // grid can store slot indices that survive swap-removal. whole Rects rather than
+    // one array per field, since grid candidates are looked up one at a time.
+    std::vector<Rect> areas;
+
+    EntityHandle add(Entity* e)
+    {
+        uint32_t index;
+        if (!freeSlots.empty())
+        {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            index = uint32_t(slots.size());
+            slots.push_back(Slot());
+            slots.back().generation = 1;
+            areas.push_back(Rect());
+        }
+        Slot& slot = slots[index];
+        slot.dense = uint32_t(dense.size());
+        dense.push_back(e);
+        denseSlots.push_back(index);
+        return {index, slot.generation};
+    }
+
+    // Swap-removes from the dense array. Returns false and changes nothing if
+    // handle is stale, foreign or already removed.
+    bool remove(EntityHandle handle)
+    {
+        if (!contains(handle))
+        {
+            return false;
+        }
+        Slot& slot = slots[handle.index];
+        uint32_t last = uint32_t(dense.size() - 1);
+        if (slot.dense != last)
+        {
+            dense[slot.dense] = dense[last];
+            denseSlots[slot.dense] = denseSlots[last];
+            slots[denseSlots[slot.dense]].dense = slot.dense;
+        }
+        dense.pop_back();
+        denseSlots.pop_back();
+
+        slot.dense = kNoDense;
+        if (++slot.generation == 0)
+        {
+            slot.generation = 1;
+        }
+        freeSlots.push_back(handle.index);
+        return true;
+    }
+
+    bool contains(EntityHandle handle) const
+    {
+        return handle.index < slots.size() && handle.generation != 0 && slots[handle.index].generation == handle.generation &&
+               slots[handle.index].dense != kNoDense;
+    }
+
+    // nullptr once the entity has been removed.
+    Entity* get(EntityHandle handle) const
+    {
+        return contains(handle) ? dense[slots[handle.index].dense] : nullptr;
+    }
+
+    // Entity in a slot known to be occupied, such as one stored in the grid.
+    Entity* getAt(uint32_t index) const
+    {
+        assert(slots[index].dense != kNoDense);
+        return dense[slots[index].dense];
+    }
+
+    void setArea(uint32_t index, const Rect& area)
+    {
+        areas[index] = area;
+    }
+
+    const Rect& getArea(uint32_t index) const
+    {
+        return areas[index];
+    }
+
+    size_t size() const
+    {
+        return dense.size();
+    }
+
+    std::vector<Entity*>::const_iterator begin() const
+    {
+        return dense.begin();
+    }
+
+    std::vector<Entity*>::const_iterator end() const
+    {
+        return dense.end();
+    }
+};
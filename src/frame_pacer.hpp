@@ -0,0 +1,108 @@
+#pragma once
+
+#include <SDL.h>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <thread>
+
+// Paces frames against absolute deadlines. Sleeps with SDL_Delay while more
+// than spinMargin remains, then polls the performance counter, yielding the
+// core between polls, so frames land close to the target instead of a
+// scheduler quantum late without burning a core on the wait.
+struct FramePacer {
+    double targetRate = 60.0;
+    // left to poll after sleeping. under a millisecond so pacing costs little CPU.
+    double spinMargin = 0.0008;
+    bool enabled = true;
+    bool report = false;
+
+    uint64_t freq = 0;
+    uint64_t period = 0;
+    uint64_t deadline = 0;
+    uint64_t prevTime = 0;
+
+    // pacing error is how late a frame started relative to its deadline.
+    uint32_t numFrames = 0;
+    double sumError = 0.0;
+    double maxError = 0.0;
+    uint64_t reportTime = 0;
+
+    void createFramePacer(double rate)
+    {
+        targetRate = rate;
+        enabled = rate > 0.0;
+        freq = SDL_GetPerformanceFrequency();
+        period = enabled ? uint64_t(double(freq) / rate) : 0;
+        prevTime = SDL_GetPerformanceCounter();
+        deadline = prevTime + period;
+        reportTime = prevTime;
+    }
+
+    // With swap-interval vsync the swap already blocks, so pacing on top of it
+    // would only add jitter.
+    void detectVSync()
+    {
+        int interval = SDL_GL_GetSwapInterval();
+        if (interval != 0 && enabled)
+        {
+            printf("FramePacer: swap interval %d is active, frame limiting disabled\n", interval);
+            enabled = false;
+        }
+    }
+
+    // Waits for the next frame deadline and returns the seconds since the previous frame.
+    double waitForNextFrame()
+    {
+        uint64_t now = SDL_GetPerformanceCounter();
+        if (enabled)
+        {
+            while (now < deadline)
+            {
+                double remaining = double(deadline - now) / freq;
+                // SDL_Delay takes whole milliseconds. rounding leaves within half a millisecond of spinMargin to poll.
+                uint32_t sleepMs = uint32_t((remaining - spinMargin) * 1000.0 + 0.5);
+                if (remaining > spinMargin && sleepMs > 0)
+                {
+                    SDL_Delay(sleepMs);
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+                now = SDL_GetPerformanceCounter();
+            }
+
+            double error = double(now - deadline) / freq;
+            numFrames++;
+            sumError += error;
+            maxError = fmax(maxError, error);
+
+            deadline += period;
+            if (deadline <= now)
+            {
+                // fell a whole frame or more behind. restart from now instead of bursting to catch up.
+                deadline = now + period;
+            }
+            reportStats(now);
+        }
+
+        double dt = double(now - prevTime) / freq;
+        prevTime = now;
+        return dt;
+    }
+
+    void reportStats(uint64_t now)
+    {
+        if (!report || now - reportTime < freq * 5)
+        {
+            return;
+        }
+        printf("FramePacer: target: %.2f Hz, frames: %u, mean error: %.3f ms, max error: %.3f ms\n",
+               targetRate, numFrames, sumError / numFrames * 1000.0, maxError * 1000.0);
+        numFrames = 0;
+        sumError = 0.0;
+        maxError = 0.0;
+        reportTime = now;
+    }
+};
@@ -1,51 +1,51 @@
 #pragma once
 
 #include "glad.h"
+#include "game_app_state.hpp"
+#include "frame_pacer.hpp"
+#include "input_record.hpp"
+#include "profiler.hpp"
 #include <SDL.h>
 #include <cassert>
 #include <cstdio>
 #include <cstdint>
-
-enum GameAppKey {
-    kGameAppKeyW = 0,
-    kGameAppKeyA,
-    kGameAppKeyS,
-    kGameAppKeyD,
-    kGameAppKeyX,
-    kGameAppKeyC,
-    kGameAppKeyRight,
-    kGameAppKeyLeft,
-    kGameAppKeyUp,
-    kGameAppKeyDown,
-    kGameAppKeySpace,
-    kGameAppKeyLShift,
-    kNumGameAppKey
-};
+#include <cmath>
 
 struct GameAppConfig {
     uint32_t width = 0;
     uint32_t height = 0;
     const char* title = nullptr;
     bool debug_gl = false;
-};
-
-struct GameAppState {
-    bool isPressedLMB = false;
-    bool isPressedMMB = false;
-    bool isPressedRMB = false;
-    uint32_t mouseX = 0;
-    uint32_t mouseY = 0;
-    uint32_t mousePrevX = 0;
-    uint32_t mousePrevY = 0;
-    int32_t mouseWheelY = 0;
-    bool isPressedKey[kNumGameAppKey] = {false};
-    double dt = 0.0;
+    // simulation rate, and how many simulation steps a slow frame may catch up.
+    double fixedDt = 1.0 / 60.0;
+    uint32_t maxFixedSteps = 5;
+    // render rate cap, independent of fixedDt. 0 disables the cap.
+    double maxFrameRate = 60.0;
+    // request swap-interval vsync. the frame limiter steps aside when it is active.
+    bool vsync = false;
+    bool reportFramePacing = false;
+    // runHeadlessGameApp: fixed steps to run and optional input script.
+    uint64_t headlessTicks = 0;
+    const char* inputScript = nullptr;
+    // write every fixed tick's input and state hash to recordFile, or feed the
+    // simulation from replayFile instead of SDL and check its hashes.
+    const char* recordFile = nullptr;
+    const char* replayFile = nullptr;
 };
 
 struct GameApp {
+    // loads what the simulation needs. must not touch GL. called before onInit.
+    void (*onInitSimulation)() = []() {};
     void (*onInit)() = []() {};
     void (*onShutdown)() = []() {};
+    // once per rendered frame, before the fixed steps.
     void (*onUpdate)(const GameAppState&) = [](const GameAppState&) {};
+    // zero or more times per frame, each advancing the simulation by exactly dt.
+    void (*onFixedUpdate)(const GameAppState&, double dt) = [](const GameAppState&, double) {};
+    // once per frame. alpha in [0, 1) is how far the frame is between the last two fixed steps.
+    void (*onRender)(const GameAppState&, float alpha) = [](const GameAppState&, float) {};
+    // hash of the simulation state after a fixed step, for recording and replay checks.
+    uint64_t (*onHashState)() = []() -> uint64_t { return 0; };
 };
 
 extern void debugGLMessageCallback(GLenum source, GLenum type, unsigned int id, GLenum severity, GLsizei length, const char* message, const void* userParam);
@@ -87,28 +87,39 @@ void runGameApp(GameApp app, GameAppConfig appConfig)
         glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
     }
 
-    app.onInit();
+    SDL_GL_SetSwapInterval(appConfig.vsync ? 1 : 0);
 
-    double fpsCap = 1.0 / 60.0;
-    uint64_t freq = SDL_GetPerformanceFrequency();
-    uint64_t prevTime = SDL_GetPerformanceCounter();
+    {
+        PROFILE_SCOPE("onInit");
+        app.onInitSimulation();
+        app.onInit();
+    }
+
+    FramePacer pacer;
+    pacer.report = appConfig.reportFramePacing;
+    pacer.createFramePacer(appConfig.maxFrameRate);
+    pacer.detectVSync();
 
     GameAppState state = {};
+    double accumulator = 0.0;
 
-    for (;;)
+    InputRecorder recorder;
+    InputReplay replay;
+    if (appConfig.replayFile)
     {
-        uint64_t nowTime = SDL_GetPerformanceCounter();
-        double deltaTime = double(nowTime - prevTime) / freq;
-        prevTime = nowTime;
+        replay.loadReplay(appConfig.replayFile);
+        appConfig.fixedDt = replay.fixedDt;
+    }
+    if (appConfig.recordFile)
+    {
+        recorder.openRecording(appConfig.recordFile, appConfig.fixedDt);
+    }
+    uint64_t tick = 0;
 
-        while (deltaTime < fpsCap)
-        {
-            uint32_t ms = (uint32_t)((fpsCap - deltaTime) * 1000.0);
-            SDL_Delay(ms);
-            nowTime = SDL_GetPerformanceCounter();
-            deltaTime += double(nowTime - prevTime) / freq;
-            prevTime = nowTime;
-        }
+    for (;;)
+    {
+        PROFILE_SCOPE("frame");
+        double deltaTime = pacer.waitForNextFrame();
 
         state.mouseWheelY = 0;
         SDL_Event ev;
@@ -118,6 +129,10 @@ void runGameApp(GameApp app, GameAppConfig appConfig)
             {
                 goto app_quit;
             }
+            else if (ev.type == SDL_KEYDOWN && ev.key.keysym.scancode == SDL_SCANCODE_F9 && !ev.key.repeat)
+            {
+                PROFILE_WRITE_TRACE("profile.json");
+            }
             else if (ev.type == SDL_MOUSEWHEEL)
             {
                 state.mouseWheelY = ev.wheel.y;
@@ -158,13 +173,71 @@ void runGameApp(GameApp app, GameAppConfig appConfig)
         }
 
         state.dt = deltaTime;
-        app.onUpdate(state);
+        {
+            PROFILE_SCOPE("onUpdate");
+            app.onUpdate(state);
+        }
+
+        accumulator += deltaTime;
+        uint32_t steps = 0;
+        for (; accumulator >= appConfig.fixedDt && steps < appConfig.maxFixedSteps; ++steps)
+        {
+            GameAppState tickState = state;
+            tickState.dt = appConfig.fixedDt;
+            if (appConfig.replayFile)
+            {
+                if (replay.isFinished(tick))
+                {
+                    goto app_quit;
+                }
+                replay.applyTick(tick, tickState);
+            }
+            {
+                PROFILE_SCOPE("onFixedUpdate");
+                app.onFixedUpdate(tickState, appConfig.fixedDt);
+            }
+            if (appConfig.recordFile || appConfig.replayFile)
+            {
+                uint64_t hash = app.onHashState();
+                if (appConfig.recordFile)
+                {
+                    recorder.record(tickState, hash);
+                }
+                if (appConfig.replayFile)
+                {
+                    replay.checkTick(tick, hash);
+                }
+            }
+            tick++;
+            accumulator -= appConfig.fixedDt;
+        }
+        if (accumulator >= appConfig.fixedDt)
+        {
+            // too far behind to catch up. drop the backlog instead of spiralling.
+            accumulator = fmod(accumulator, appConfig.fixedDt);
+        }
+
+        state.dt = deltaTime;
+        {
+            PROFILE_SCOPE("onRender");
+            app.onRender(state, float(accumulator / appConfig.fixedDt));
+        }
 
+        PROFILE_SCOPE("SDL_GL_SwapWindow");
         SDL_GL_SwapWindow(window);
     }
 
 app_quit:
     app.onShutdown();
+    if (appConfig.recordFile)
+    {
+        recorder.closeRecording();
+    }
+    if (appConfig.replayFile)
+    {
+        replay.reportReplay();
+    }
+    PROFILE_WRITE_TRACE("profile.json");
 
     SDL_GL_DeleteContext(glctx);
     SDL_DestroyWindow(window);
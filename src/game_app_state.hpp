@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+enum GameAppKey {
+    kGameAppKeyW = 0,
+    kGameAppKeyA,
+    kGameAppKeyS,
+    kGameAppKeyD,
+    kGameAppKeyX,
+    kGameAppKeyC,
+    kGameAppKeyRight,
+    kGameAppKeyLeft,
+    kGameAppKeyUp,
+    kGameAppKeyDown,
+    kGameAppKeySpace,
+    kGameAppKeyLShift,
+    kNumGameAppKey
+};
+
+struct GameAppState {
+    bool isPressedLMB = false;
+    bool isPressedMMB = false;
+    bool isPressedRMB = false;
+    uint32_t mouseX = 0;
+    uint32_t mouseY = 0;
+    uint32_t mousePrevX = 0;
+    uint32_t mousePrevY = 0;
+    int32_t mouseWheelY = 0;
+    bool isPressedKey[kNumGameAppKey] = {false};
+    double dt = 0.0;
+};
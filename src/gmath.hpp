@@ -3,21 +3,43 @@
 #include <cmath>
 #include <cfloat>
 
+// define GMATH_NO_SIMD to build only the scalar paths.
+#if defined(GMATH_NO_SIMD)
+#elif defined(__AVX__)
+#include <immintrin.h>
+#define GMATH_AVX
+#define GMATH_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GMATH_SSE2
+#endif
+
+struct Vector2 {
+    float x, y;
+};
+
 struct Vector3 {
     float x, y, z;
 };
 
-struct Vector4 {
+struct alignas(16) Vector4 {
     float x, y, z, w;
 };
 
-struct Matrix4 {
+struct alignas(16) Matrix4 {
     float m11, m12, m13, m14,
         m21, m22, m23, m24,
         m31, m32, m33, m34,
         m41, m42, m43, m44;
 };
 
+// 2D affine transform for row vectors: [x y 1] * M.
+struct Matrix3x2 {
+    float m11, m12,
+        m21, m22,
+        m31, m32;
+};
+
 struct Quaternion {
     float x, y, z, w;
 };
@@ -63,6 +85,11 @@ inline Vector3 vec3Multiply(const Vector3& v, float scalar)
     return {v.x * scalar, v.y * scalar, v.z * scalar};
 }
 
+inline Vector3 vec3Lerp(const Vector3& a, const Vector3& b, float t)
+{
+    return {a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t};
+}
+
 inline float vec3Dot(const Vector3& a, const Vector3& b)
 {
     const float* A = (const float*)&a;
@@ -131,7 +158,9 @@ inline Vector4 vec4One()
     return {1.0F, 1.0F, 1.0F, 1.0F};
 }
 
-inline Vector4 vec4Transform(const Vector4& v, const Matrix4& m)
+// The SIMD kernels add the same products in the same order as the scalar
+// loops, starting from zero, so all paths give bit-identical results.
+inline Vector4 vec4TransformScalar(const Vector4& v, const Matrix4& m)
 {
     Vector4 result = vec4Zero();
     const float* A = (const float*)&v;
@@ -149,6 +178,23 @@ inline Vector4 vec4Transform(const Vector4& v, const Matrix4& m)
     return result;
 }
 
+inline Vector4 vec4Transform(const Vector4& v, const Matrix4& m)
+{
+#if defined(GMATH_SSE2)
+    const float* B = (const float*)&m;
+    __m128 r = _mm_setzero_ps();
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.x), _mm_load_ps(B + 0)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.y), _mm_load_ps(B + 4)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.z), _mm_load_ps(B + 8)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(v.w), _mm_load_ps(B + 12)));
+    Vector4 result;
+    _mm_store_ps((float*)&result, r);
+    return result;
+#else
+    return vec4TransformScalar(v, m);
+#endif
+}
+
 inline Matrix4 mat4Zero()
 {
     return {
@@ -172,7 +218,7 @@ inline const float* mat4Ptr(const Matrix4& m)
     return (const float*)&m;
 }
 
-inline Matrix4 mat4Multiply(const Matrix4& a, const Matrix4& b)
+inline Matrix4 mat4MultiplyScalar(const Matrix4& a, const Matrix4& b)
 {
     Matrix4 m = mat4Zero();
     const float* A = (const float*)&a;
@@ -191,6 +237,53 @@ inline Matrix4 mat4Multiply(const Matrix4& a, const Matrix4& b)
     return m;
 }
 
+inline Matrix4 mat4Multiply(const Matrix4& a, const Matrix4& b)
+{
+#if defined(GMATH_AVX)
+    // two rows of a per 256-bit register. each lane broadcasts its own row's element.
+    const float* A = (const float*)&a;
+    const float* B = (const float*)&b;
+    __m256 b0 = _mm256_broadcast_ps((const __m128*)(B + 0));
+    __m256 b1 = _mm256_broadcast_ps((const __m128*)(B + 4));
+    __m256 b2 = _mm256_broadcast_ps((const __m128*)(B + 8));
+    __m256 b3 = _mm256_broadcast_ps((const __m128*)(B + 12));
+    Matrix4 m;
+    float* M = (float*)&m;
+    for (int i = 0; i < 16; i += 8)
+    {
+        __m256 rows = _mm256_loadu_ps(A + i);
+        __m256 r = _mm256_setzero_ps();
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(rows, 0x00), b0));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(rows, 0x55), b1));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(rows, 0xAA), b2));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(rows, 0xFF), b3));
+        _mm256_storeu_ps(M + i, r);
+    }
+    return m;
+#elif defined(GMATH_SSE2)
+    const float* A = (const float*)&a;
+    const float* B = (const float*)&b;
+    __m128 b0 = _mm_load_ps(B + 0);
+    __m128 b1 = _mm_load_ps(B + 4);
+    __m128 b2 = _mm_load_ps(B + 8);
+    __m128 b3 = _mm_load_ps(B + 12);
+    Matrix4 m;
+    float* M = (float*)&m;
+    for (int i = 0; i < 16; i += 4)
+    {
+        __m128 r = _mm_setzero_ps();
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(A[i + 0]), b0));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(A[i + 1]), b1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(A[i + 2]), b2));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(A[i + 3]), b3));
+        _mm_store_ps(M + i, r);
+    }
+    return m;
+#else
+    return mat4MultiplyScalar(a, b);
+#endif
+}
+
 inline Matrix4 mat4CreateTranslation(Vector3 v)
 {
     return {
@@ -290,6 +383,65 @@ inline Matrix4 mat4LookAt(const Vector3& eye, const Vector3& center, const Vecto
     return mat4Multiply(translation, rotation);
 }
 
+inline Vector2 vec2(float x, float y)
+{
+    return {x, y};
+}
+
+inline Vector2 vec2Transform(const Vector2& v, const Matrix3x2& m)
+{
+    return {
+        v.x * m.m11 + v.y * m.m21 + m.m31,
+        v.x * m.m12 + v.y * m.m22 + m.m32};
+}
+
+inline Matrix3x2 mat3x2Identity()
+{
+    return {
+        1.0F, 0.0F,
+        0.0F, 1.0F,
+        0.0F, 0.0F};
+}
+
+inline Matrix3x2 mat3x2CreateScale(Vector2 v)
+{
+    return {
+        v.x, 0.0F,
+        0.0F, v.y,
+        0.0F, 0.0F};
+}
+
+// Same rotation as mat4CreateFromAxisAngle around +z.
+inline Matrix3x2 mat3x2CreateRotation(float angleRadian)
+{
+    float c = cosf(angleRadian);
+    float s = sinf(angleRadian);
+    return {
+        c, s,
+        -s, c,
+        0.0F, 0.0F};
+}
+
+inline Matrix3x2 mat3x2CreateTranslation(Vector2 v)
+{
+    return {
+        1.0F, 0.0F,
+        0.0F, 1.0F,
+        v.x, v.y};
+}
+
+// a then b.
+inline Matrix3x2 mat3x2Multiply(const Matrix3x2& a, const Matrix3x2& b)
+{
+    return {
+        a.m11 * b.m11 + a.m12 * b.m21,
+        a.m11 * b.m12 + a.m12 * b.m22,
+        a.m21 * b.m11 + a.m22 * b.m21,
+        a.m21 * b.m12 + a.m22 * b.m22,
+        a.m31 * b.m11 + a.m32 * b.m21 + b.m31,
+        a.m31 * b.m12 + a.m32 * b.m22 + b.m32};
+}
+
 inline Quaternion quatIdentity()
 {
     return {0.0F, 0.0F, 0.0F, 1.0F};
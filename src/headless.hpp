@@ -0,0 +1,90 @@
+#pragma once
+
+#include "game_app.hpp"
+#include "input_script.hpp"
+#include "input_record.hpp"
+#include "profiler.hpp"
+#include <SDL.h>
+#include <cstdint>
+#include <cstdio>
+
+// Steps the simulation as fast as possible with no window, GL or SDL events.
+void runHeadlessGameApp(GameApp app, GameAppConfig appConfig)
+{
+    InputScript script;
+    if (appConfig.inputScript)
+    {
+        script.loadInputScript(appConfig.inputScript);
+    }
+
+    InputRecorder recorder;
+    InputReplay replay;
+    if (appConfig.replayFile)
+    {
+        replay.loadReplay(appConfig.replayFile);
+        appConfig.fixedDt = replay.fixedDt;
+        if (appConfig.headlessTicks == 0)
+        {
+            appConfig.headlessTicks = replay.records.size();
+        }
+    }
+    if (appConfig.recordFile)
+    {
+        recorder.openRecording(appConfig.recordFile, appConfig.fixedDt);
+    }
+
+    {
+        PROFILE_SCOPE("onInitSimulation");
+        app.onInitSimulation();
+    }
+
+    GameAppState state = {};
+    state.dt = appConfig.fixedDt;
+    uint64_t freq = SDL_GetPerformanceFrequency();
+    uint64_t startTime = SDL_GetPerformanceCounter();
+    uint64_t tick = 0;
+    for (; tick < appConfig.headlessTicks; ++tick)
+    {
+        if (appConfig.replayFile)
+        {
+            if (replay.isFinished(tick))
+            {
+                break;
+            }
+            replay.applyTick(tick, state);
+        }
+        else
+        {
+            script.applyTick(tick, state);
+        }
+        {
+            PROFILE_SCOPE("onFixedUpdate");
+            app.onFixedUpdate(state, appConfig.fixedDt);
+        }
+        if (appConfig.recordFile || appConfig.replayFile)
+        {
+            uint64_t hash = app.onHashState();
+            if (appConfig.recordFile)
+            {
+                recorder.record(state, hash);
+            }
+            if (appConfig.replayFile)
+            {
+                replay.checkTick(tick, hash);
+            }
+        }
+    }
+    double elapsed = double(SDL_GetPerformanceCounter() - startTime) / freq;
+
+    printf("headless: ticks: %llu, time: %.3f s, ticks per second: %.0f\n",
+           (unsigned long long)tick, elapsed, elapsed > 0.0 ? double(tick) / elapsed : 0.0);
+    if (appConfig.recordFile)
+    {
+        recorder.closeRecording();
+    }
+    if (appConfig.replayFile)
+    {
+        replay.reportReplay();
+    }
+    PROFILE_WRITE_TRACE("profile.json");
+}
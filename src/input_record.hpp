@@ -0,0 +1,183 @@
+#pragma once
+
+#include "game_app_state.hpp"
+#include "hash.hpp"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Records the GameAppState fed to every fixed tick into a compact binary file,
+// together with a hash of the simulation state after the tick, and replays it
+// in place of SDL input. A replay compares hashes tick by tick and reports the
+// first divergence.
+//
+// File layout, little-endian:
+//   header: "HNRP", uint32 version, double fixedDt
+//   per tick: uint16 keys, uint8 mouse buttons, int16 wheel,
+//             uint16 mouseX, mouseY, mousePrevX, mousePrevY, double dt, uint64 hash
+
+struct InputRecord {
+    static constexpr size_t kSize = 2 + 1 + 2 + 2 * 4 + 8 + 8;
+
+    GameAppState state;
+    uint64_t hash = 0;
+
+    void write(uint8_t* out) const
+    {
+        uint16_t keys = 0;
+        for (int i = 0; i < kNumGameAppKey; ++i)
+        {
+            keys |= state.isPressedKey[i] ? uint16_t(1 << i) : uint16_t(0);
+        }
+        uint8_t buttons = (state.isPressedLMB ? 1 : 0) | (state.isPressedMMB ? 2 : 0) | (state.isPressedRMB ? 4 : 0);
+        int16_t wheel = int16_t(state.mouseWheelY);
+        uint16_t mouse[4] = {uint16_t(state.mouseX), uint16_t(state.mouseY), uint16_t(state.mousePrevX), uint16_t(state.mousePrevY)};
+
+        memcpy(out, &keys, 2);
+        memcpy(out + 2, &buttons, 1);
+        memcpy(out + 3, &wheel, 2);
+        memcpy(out + 5, mouse, 8);
+        memcpy(out + 13, &state.dt, 8);
+        memcpy(out + 21, &hash, 8);
+    }
+
+    void read(const uint8_t* in)
+    {
+        uint16_t keys = 0;
+        uint8_t buttons = 0;
+        int16_t wheel = 0;
+        uint16_t mouse[4] = {0};
+        memcpy(&keys, in, 2);
+        memcpy(&buttons, in + 2, 1);
+        memcpy(&wheel, in + 3, 2);
+        memcpy(mouse, in + 5, 8);
+        memcpy(&state.dt, in + 13, 8);
+        memcpy(&hash, in + 21, 8);
+
+        for (int i = 0; i < kNumGameAppKey; ++i)
+        {
+            state.isPressedKey[i] = (keys & (1 << i)) != 0;
+        }
+        state.isPressedLMB = (buttons & 1) != 0;
+        state.isPressedMMB = (buttons & 2) != 0;
+        state.isPressedRMB = (buttons & 4) != 0;
+        state.mouseWheelY = wheel;
+        state.mouseX = mouse[0];
+        state.mouseY = mouse[1];
+        state.mousePrevX = mouse[2];
+        state.mousePrevY = mouse[3];
+    }
+};
+
+struct InputRecorder {
+    static constexpr uint32_t kVersion = 1;
+
+    FILE* fp = nullptr;
+    uint64_t numTicks = 0;
+
+    void openRecording(const char* fileName, double fixedDt)
+    {
+        assert(!fp);
+        fp = fopen(fileName, "wb");
+        assert(fp);
+        fwrite("HNRP", 1, 4, fp);
+        fwrite(&kVersion, sizeof(kVersion), 1, fp);
+        fwrite(&fixedDt, sizeof(fixedDt), 1, fp);
+        numTicks = 0;
+        printf("openRecording: %s\n", fileName);
+    }
+
+    void record(const GameAppState& state, uint64_t hash)
+    {
+        assert(fp);
+        InputRecord r;
+        r.state = state;
+        r.hash = hash;
+        uint8_t buffer[InputRecord::kSize];
+        r.write(buffer);
+        fwrite(buffer, 1, sizeof(buffer), fp);
+        numTicks++;
+    }
+
+    void closeRecording()
+    {
+        assert(fp);
+        fclose(fp);
+        fp = nullptr;
+        printf("closeRecording: ticks: %llu\n", (unsigned long long)numTicks);
+    }
+};
+
+struct InputReplay {
+    std::vector<InputRecord> records;
+    double fixedDt = 0.0;
+    uint64_t numDiverged = 0;
+    uint64_t firstDivergence = 0;
+
+    void loadReplay(const char* fileName)
+    {
+        FILE* fp = fopen(fileName, "rb");
+        assert(fp);
+        char magic[4] = {0};
+        uint32_t version = 0;
+        bool ok = fread(magic, 1, 4, fp) == 4 && memcmp(magic, "HNRP", 4) == 0;
+        ok = ok && fread(&version, sizeof(version), 1, fp) == 1 && version == InputRecorder::kVersion;
+        ok = ok && fread(&fixedDt, sizeof(fixedDt), 1, fp) == 1;
+        assert(ok);
+
+        records.clear();
+        uint8_t buffer[InputRecord::kSize];
+        while (fread(buffer, 1, sizeof(buffer), fp) == sizeof(buffer))
+        {
+            InputRecord r;
+            r.read(buffer);
+            records.push_back(r);
+        }
+        fclose(fp);
+        numDiverged = 0;
+        printf("loadReplay: %s, ticks: %zu, fixedDt: %f\n", fileName, records.size(), fixedDt);
+    }
+
+    bool isFinished(uint64_t tick) const
+    {
+        return tick >= records.size();
+    }
+
+    void applyTick(uint64_t tick, GameAppState& state) const
+    {
+        assert(!isFinished(tick));
+        state = records[tick].state;
+    }
+
+    void checkTick(uint64_t tick, uint64_t hash)
+    {
+        assert(!isFinished(tick));
+        if (records[tick].hash == hash)
+        {
+            return;
+        }
+        if (numDiverged == 0)
+        {
+            firstDivergence = tick;
+            printf("replay: diverged at tick %llu, expected hash %016llx, got %016llx\n",
+                   (unsigned long long)tick, (unsigned long long)records[tick].hash, (unsigned long long)hash);
+        }
+        numDiverged++;
+    }
+
+    void reportReplay() const
+    {
+        if (numDiverged == 0)
+        {
+            printf("replay: %zu ticks matched\n", records.size());
+        }
+        else
+        {
+            printf("replay: %llu of %zu ticks diverged, first at tick %llu\n",
+                   (unsigned long long)numDiverged, records.size(), (unsigned long long)firstDivergence);
+        }
+    }
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "game_app_state.hpp"
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Scripted keyboard input for headless runs. Each line holds a tick count
+// followed by the keys held for those ticks, e.g. "30 right up". Blank lines
+// and lines starting with '#' are ignored. The script repeats when it runs out.
+struct InputScript {
+    struct Step {
+        uint32_t ticks;
+        bool isPressedKey[kNumGameAppKey];
+    };
+
+    std::vector<Step> steps;
+    uint64_t totalTicks = 0;
+
+    static int findKey(const std::string& name)
+    {
+        static const char* names[kNumGameAppKey] = {
+            "w",
+            "a",
+            "s",
+            "d",
+            "x",
+            "c",
+            "right",
+            "left",
+            "up",
+            "down",
+            "space",
+            "lshift"};
+        for (int i = 0; i < kNumGameAppKey; ++i)
+        {
+            if (name == names[i])
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void loadInputScript(const char* fileName)
+    {
+        std::ifstream file(fileName);
+        assert(file.good());
+
+        steps.clear();
+        totalTicks = 0;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+            std::istringstream ss(line);
+            Step step = {};
+            if (!(ss >> step.ticks))
+            {
+                continue;
+            }
+            std::string name;
+            while (ss >> name)
+            {
+                int key = findKey(name);
+                if (key < 0)
+                {
+                    printf("loadInputScript: unknown key: %s\n", name.c_str());
+                    continue;
+                }
+                step.isPressedKey[key] = true;
+            }
+            steps.push_back(step);
+            totalTicks += step.ticks;
+        }
+        printf("loadInputScript: %s, steps: %zu, ticks: %llu\n", fileName, steps.size(), (unsigned long long)totalTicks);
+    }
+
+    void applyTick(uint64_t tick, GameAppState& state) const
+    {
+        memset(state.isPressedKey, 0, sizeof(state.isPressedKey));
+        if (totalTicks == 0)
+        {
+            return;
+        }
+        tick %= totalTicks;
+        for (const Step& step : steps)
+        {
+            if (tick < step.ticks)
+            {
+                memcpy(state.isPressedKey, step.isPressedKey, sizeof(state.isPressedKey));
+                return;
+            }
+            tick -= step.ticks;
+        }
+    }
+};
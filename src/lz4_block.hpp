@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Minimal encoder and decoder for the LZ4 block format: greedy matching over a
+// 4 KiB-entry hash table. Compresses far worse than the reference encoder but
+// decodes at memcpy-like speed, which is what asset loading cares about.
+
+inline void lz4WriteLength(std::vector<uint8_t>& out, size_t n)
+{
+    for (; n >= 255; n -= 255)
+    {
+        out.push_back(255);
+    }
+    out.push_back(uint8_t(n));
+}
+
+inline void lz4WriteSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t numLiterals, size_t offset, size_t matchLength)
+{
+    size_t m = matchLength >= 4 ? matchLength - 4 : 0;
+    out.push_back(uint8_t((numLiterals >= 15 ? 15 : numLiterals) << 4 | (m >= 15 ? 15 : m)));
+    if (numLiterals >= 15)
+    {
+        lz4WriteLength(out, numLiterals - 15);
+    }
+    out.insert(out.end(), literals, literals + numLiterals);
+    if (matchLength == 0)
+    {
+        return;
+    }
+    out.push_back(uint8_t(offset));
+    out.push_back(uint8_t(offset >> 8));
+    if (m >= 15)
+    {
+        lz4WriteLength(out, m - 15);
+    }
+}
+
+inline std::vector<uint8_t> lz4Compress(const uint8_t* src, size_t size)
+{
+    static constexpr size_t kHashBits = 12;
+    static constexpr size_t kMinMatch = 4;
+    // the format requires the last 5 bytes to be literals and the last match to start 12 bytes before the end.
+    static constexpr size_t kLastLiterals = 5;
+    static constexpr size_t kMatchLimit = 12;
+
+    std::vector<uint8_t> out;
+    out.reserve(size / 2 + 16);
+    std::vector<uint32_t> table(size_t(1) << kHashBits, 0);
+    auto hash4 = [&](size_t i) {
+        uint32_t v;
+        memcpy(&v, src + i, 4);
+        return (v * 2654435761U) >> (32 - kHashBits);
+    };
+
+    size_t anchor = 0;
+    size_t i = 0;
+    while (size >= kMatchLimit && i + kMatchLimit <= size)
+    {
+        uint32_t h = hash4(i);
+        size_t candidate = table[h];
+        table[h] = uint32_t(i);
+        if (candidate < i && i - candidate <= 0xFFFF && memcmp(src + candidate, src + i, kMinMatch) == 0)
+        {
+            size_t length = kMinMatch;
+            while (i + length < size - kLastLiterals && src[candidate + length] == src[i + length])
+            {
+                length++;
+            }
+            lz4WriteSequence(out, src + anchor, i - anchor, i - candidate, length);
+            i += length;
+            anchor = i;
+        }
+        else
+        {
+            i++;
+        }
+    }
+    lz4WriteSequence(out, src + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+// false if src is malformed or does not decode to exactly dstSize bytes.
+inline bool lz4Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+{
+    const uint8_t* ip = src;
+    const uint8_t* ipEnd = src + srcSize;
+    uint8_t* op = dst;
+    uint8_t* opEnd = dst + dstSize;
+    auto readLength = [&](size_t& n) {
+        uint8_t b = 255;
+        while (b == 255)
+        {
+            if (ip >= ipEnd)
+            {
+                return false;
+            }
+            b = *ip++;
+            n += b;
+        }
+        return true;
+    };
+
+    while (ip < ipEnd)
+    {
+        uint8_t token = *ip++;
+        size_t numLiterals = token >> 4;
+        if (numLiterals == 15 && !readLength(numLiterals))
+        {
+            return false;
+        }
+        if (size_t(ipEnd - ip) < numLiterals || size_t(opEnd - op) < numLiterals)
+        {
+            return false;
+        }
+        memcpy(op, ip, numLiterals);
+        ip += numLiterals;
+        op += numLiterals;
+        if (ip == ipEnd)
+        {
+            break;
+        }
+
+        if (ipEnd - ip < 2)
+        {
+            return false;
+        }
+        size_t offset = size_t(ip[0]) | size_t(ip[1]) << 8;
+        ip += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(matchLength))
+        {
+            return false;
+        }
+        matchLength += 4;
+        if (offset == 0 || size_t(op - dst) < offset || size_t(opEnd - op) < matchLength)
+        {
+            return false;
+        }
+        // byte by byte, since the match may overlap what it is copying.
+        const uint8_t* match = op - offset;
+        for (size_t k = 0; k < matchLength; ++k)
+        {
+            op[k] = match[k];
+        }
+        op += matchLength;
+    }
+    return op == opEnd;
+}
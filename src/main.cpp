@@ -1,5 +1,6 @@
 #define SDL_MAIN_HANDLED
 #include "game_app.hpp"
+#include "headless.hpp"
 #include "camera.hpp"
 #include "sprite.hpp"
 #include "tilemap.hpp"
@@ -7,6 +8,13 @@
 #include "player.hpp"
 #include "sprite_sheet.hpp"
 #include "framebuffer.hpp"
+#include "sprite_batch.hpp"
+#include "asset_loader.hpp"
+#include "asset_cache.hpp"
+#include "asset_pack.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <random>
 
 #define VSCR_X 384
 #define VSCR_Y 216
@@ -20,12 +28,44 @@ TileMap gTileMap;
 
 Player player;
 
-Sprite gAtlas;
+// Collision load for --spawn: walks until it bumps into something, then turns around.
+struct Crawler : Entity {
+    float hsp = 0.5F;
+
+    void update()
+    {
+        if (moveX(hsp))
+        {
+            hsp = -hsp;
+        }
+        moveY(-1.0F);
+    }
+};
+
+// reserved up front since the registry and the grid keep pointers into it.
+std::vector<Crawler> gCrawlers;
+uint32_t gNumCrawlers = 0;
+
+Sprite* gAtlas = nullptr;
 Sprite gSubSpr;
 SpriteSheet gSprSheet;
 
 FrameBuffer gFBO[2];
 
+SpriteBatch gSpriteBatch;
+
+AssetLoader gAssetLoader;
+AssetCache gAssetCache;
+// seconds of GL uploads per frame while assets stream in.
+const double kAssetUploadBudget = 0.002;
+// decode threads. 0 picks one per core, 1 decodes serially.
+uint32_t gLoadThreads = 0;
+uint64_t gStartTime = 0;
+bool gDrewFirstFrame = false;
+
+const char* gMapFile = "first.json";
+AssetPack gAssetPack;
+
 void initOpenGL()
 {
     glEnable(GL_BLEND);
@@ -40,23 +80,132 @@ void initOpenGL()
 
     gFBO[0].createFrameBuffer(VSCR_X, VSCR_Y);
     gFBO[1].createFrameBuffer(640, 480);
+    gSpriteBatch.createSpriteBatch();
+}
+
+// Scatters n crawlers over free space in gTileMap. Seeded so benchmark runs are comparable.
+void spawnCrawlers(uint32_t n)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    gCrawlers.reserve(n);
+    std::mt19937 rng(1234);
+    float halfW = gTileMap.width * gTileMap.tileWidth / 2.0F;
+    float halfH = gTileMap.height * gTileMap.tileHeight / 2.0F;
+    std::uniform_real_distribution<float> randX(-halfW, halfW);
+    std::uniform_real_distribution<float> randY(-halfH, halfH);
+    for (uint32_t i = 0; i < n * 16 && gCrawlers.size() < n; ++i)
+    {
+        Rect hitbox(-3.0F, -4.0F, 6.0F, 9.0F);
+        Vector3 pos = vec3(floorf(randX(rng)), floorf(randY(rng)), 0.0F);
+        if (Entity::tileCollider->isHit(Rect(pos.x + hitbox.x, pos.y + hitbox.y, hitbox.w, hitbox.h)))
+        {
+            continue;
+        }
+        gCrawlers.emplace_back();
+        Crawler& c = gCrawlers.back();
+        c.position = pos;
+        c.prevPosition = pos;
+        c.hitbox = hitbox;
+        c.hsp = (i & 1) ? 0.5F : -0.5F;
+        Entity::addEntity(&c);
+    }
+    printf("spawnCrawlers: %zu\n", gCrawlers.size());
+}
+
+void onInitSimulation()
+{
+    ByteSpan mapData;
+    std::vector<uint8_t> mapBuffer;
+    if (AssetPack::current && AssetPack::current->getEntry(gMapFile, mapData, mapBuffer))
+    {
+        gTileMap.loadTileMapFromMemory(mapData, gMapFile);
+    }
+    else
+    {
+        gTileMap.loadTileMap(gMapFile);
+    }
+    gTileMap.createTileCollider();
+    spawnCrawlers(gNumCrawlers);
 }
 
 void onInit()
 {
     initOpenGL();
-    gSpr.loadSprite("icon.png");
-    gTileSet[2].loadSprite("tile.png");
-    gTileMap.loadTileMap("first.json");
-    gTileMap.createWallEntities();
-    gAtlas.loadSprite("playerRun.png");
-    gSubSpr.loadSubSprite(gAtlas, 32, 0, 32, 32);
-    gSprSheet.createSpriteSheet(gAtlas, 32, 32, 4);
+    gAssetLoader.createAssetLoader(gLoadThreads);
+    AssetLoader::current = &gAssetLoader;
+    Sprite* const sprites[] = {&gSpr, &gTileSet[2]};
+    const char* const fileNames[] = {"icon.png", "tile.png"};
+    gAssetLoader.loadSprites(sprites, fileNames, 2);
+    gAssetCache.createAssetCache(gAssetLoader);
+    AssetCache::current = &gAssetCache;
+    // shares the texture with the player's run sheet.
+    gAtlas = gAssetCache.acquireSprite("playerRun.png", &gAtlas, []() {
+        if (gAtlas)
+        {
+            gSubSpr.loadSubSprite(*gAtlas, 32, 0, 32, 32);
+            gSprSheet.createSpriteSheet(*gAtlas, 32, 32, 4);
+        }
+    });
     player.onPreload();
 }
 
-void onUpdate(const GameAppState& appState)
+void onUpdate(const GameAppState&)
+{
+    gAssetLoader.update(kAssetUploadBudget);
+}
+
+void onFixedUpdate(const GameAppState& appState, double)
+{
+    Entity::syncAreas();
+    player.savePrevPosition();
+    player.updateInput(appState);
+    player.update();
+    for (Crawler& c : gCrawlers)
+    {
+        c.savePrevPosition();
+        c.update();
+    }
+}
+
+// everything a fixed step carries over to the next one.
+uint64_t onHashState()
+{
+    uint64_t hash = fnv1a64(&player.position, sizeof(player.position));
+    hash = fnv1a64(&player.hsp, sizeof(player.hsp), hash);
+    hash = fnv1a64(&player.vsp, sizeof(player.vsp), hash);
+    hash = fnv1a64(&player.direction, sizeof(player.direction), hash);
+    hash = fnv1a64(&player.coyoteTime, sizeof(player.coyoteTime), hash);
+    hash = fnv1a64(&player.input.prevX, sizeof(player.input.prevX), hash);
+    hash = fnv1a64(&player.input.turnedX, sizeof(player.input.turnedX), hash);
+    hash = fnv1a64(&player.input.prevJumpBtn, sizeof(player.input.prevJumpBtn), hash);
+    hash = fnv1a64(&player.input.jumpBuffer, sizeof(player.input.jumpBuffer), hash);
+    hash = fnv1a64(&player.currentSpriteSheet, sizeof(player.currentSpriteSheet), hash);
+    for (const Crawler& c : gCrawlers)
+    {
+        hash = fnv1a64(&c.position, sizeof(c.position), hash);
+        hash = fnv1a64(&c.hsp, sizeof(c.hsp), hash);
+        hash = fnv1a64(&Entity::registry.getArea(c.handle.index), sizeof(Rect), hash);
+    }
+    return hash;
+}
+
+void onRender(const GameAppState& appState, float alpha)
 {
+    if (!gAssetLoader.isIdle())
+    {
+        // the window is up before the startup assets. show the clear color until they are.
+        glClear(GL_COLOR_BUFFER_BIT);
+        return;
+    }
+    if (!gDrewFirstFrame)
+    {
+        gDrewFirstFrame = true;
+        printf("first frame: %.3f ms after start, load threads: %zu\n",
+               double(SDL_GetPerformanceCounter() - gStartTime) * 1000.0 / SDL_GetPerformanceFrequency(), gAssetLoader.pool.threads.size());
+    }
 
     glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, gFBO[0].fbo);
     glViewport(0, 0, VSCR_X, VSCR_Y);
@@ -68,18 +217,23 @@ void onUpdate(const GameAppState& appState)
     glLoadMatrixf(mat4Ptr(cam.getMVP()));
     float x = float(appState.mouseX) - 320.0F;
     float y = (float(appState.mouseY) - 240.0F) * -1.0F;
+    Rect view = cam.getVisibleRect();
+    gSpriteBatch.begin(view);
     gTileMap.drawTileMap(gTileSet);
     //gSpr.drawSprite(x, y, deg2Rad(90.0F));
     //gSpr.drawSprite(wall.position.x, wall.position.y);
-    player.updateInput(appState);
-    player.update();
+    player.draw(alpha);
     //gSpr.drawSprite(player.position.x, player.position.y);
     //gSprSheet.update();
     //gSprSheet.drawFrame(0, 0);
-    for (auto& e : gTileMap.walls)
-    {
-        drawHitbox(e, 1.0F, 0.0F, 0.0F, 0.5F);
-    }
+    gSpriteBatch.end();
+    gSpriteBatch.reportDrawCalls();
+    gTileMap.collider.forEachRect([&view](const Rect& r) {
+        if (view.isHit(r))
+        {
+            drawRect(r, 1.0F, 0.0F, 0.0F, 0.5F);
+        }
+    });
     //drawHitbox(player, 0.0F, 1.0F, 0.0F, 0.5F);
 
     glViewport(0, 0, SCR_X, SCR_Y);
@@ -109,14 +263,123 @@ void onUpdate(const GameAppState& appState)
 
 void onShutdown()
 {
+    player.onUnload();
+    gAssetCache.releaseSprite(gAtlas, &gAtlas);
+    gAtlas = nullptr;
+    gAssetLoader.destroyAssetLoader();
+    gAssetCache.destroyAssetCache();
     gFBO[0].destroyFrameBuffer();
     gFBO[1].destroyFrameBuffer();
+    gSpriteBatch.destroySpriteBatch();
     gSpr.unloadSprite();
 }
 
-int main()
+// Checks that an AssetCache owner releasing before its load lands never sees its
+// onReady run. Uses a tile map, so no GL is needed.
+int checkAssetCache(const char* mapFile)
 {
-    stbi_set_flip_vertically_on_load(1);
+    AssetLoader loader;
+    loader.createAssetLoader();
+    AssetCache cache;
+    cache.createAssetCache(loader);
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        if (!ok)
+        {
+            printf("checkAssetCache: FAILED: %s\n", what);
+            failures++;
+        }
+    };
+    int ownerA = 0;
+    int ownerB = 0;
+    int readyA = 0;
+    int readyB = 0;
+
+    TileMap* map = cache.acquireTileMap(mapFile, &ownerA, [&readyA]() { readyA++; });
+    cache.releaseTileMap(map, &ownerA);
+    loader.waitAll();
+    check(readyA == 0, "onReady of a released owner ran");
+    check(cache.tileMaps.empty(), "map released before ready stayed resident");
+
+    readyA = 0;
+    map = cache.acquireTileMap(mapFile, &ownerA, [&readyA]() { readyA++; });
+    cache.acquireTileMap(mapFile, &ownerB, [&readyB]() { readyB++; });
+    cache.releaseTileMap(map, &ownerB);
+    loader.waitAll();
+    check(readyA == 1, "onReady of the remaining owner did not run once");
+    check(readyB == 0, "onReady of the owner that released ran");
+    check(map->tileLayer != nullptr, "map held by the remaining owner was unloaded");
+    cache.releaseTileMap(map, &ownerA);
+    check(cache.tileMaps.empty(), "map stayed resident after the last release");
+
+    map = cache.acquireTileMap(mapFile, &ownerA, [&cache, &map, &ownerA]() { cache.releaseTileMap(map, &ownerA); });
+    loader.waitAll();
+    check(cache.tileMaps.empty(), "map released from its own onReady stayed resident");
+
+    loader.destroyAssetLoader();
+    cache.destroyAssetCache();
+    printf("checkAssetCache: %s\n", failures == 0 ? "ok" : "failed");
+    return failures == 0 ? 0 : 1;
+}
+
+// Checks that EntityRegistry::remove rejects a handle that was already removed,
+// including after its slot has been reused, without disturbing live entities.
+int checkRegistry()
+{
+    int failures = 0;
+    auto check = [&failures](bool ok, const char* what) {
+        if (!ok)
+        {
+            printf("checkRegistry: FAILED: %s\n", what);
+            failures++;
+        }
+    };
+    Entity a, b, c;
+    EntityRegistry registry;
+    EntityHandle ha = registry.add(&a);
+    EntityHandle hb = registry.add(&b);
+
+    check(registry.remove(ha), "first remove failed");
+    check(!registry.remove(ha), "second remove of the same handle succeeded");
+    check(registry.size() == 1 && registry.get(hb) == &b, "second remove disturbed a live entity");
+
+    // c reuses a's slot with a new generation.
+    EntityHandle hc = registry.add(&c);
+    check(hc.index == ha.index && hc != ha, "freed slot was not reused with a new generation");
+    check(!registry.remove(ha), "stale handle removed the entity in its reused slot");
+    check(registry.get(hc) == &c && registry.size() == 2, "stale remove disturbed the reused slot");
+    check(!registry.remove(EntityHandle()), "default handle was removed");
+    check(!registry.remove({uint32_t(registry.slots.size()), 1}), "out-of-range handle was removed");
+
+    check(registry.remove(hb) && registry.remove(hc) && registry.size() == 0, "live handles were not removed");
+    // the destructors assert a handle was issued.
+    a.handle = ha;
+    b.handle = hb;
+    c.handle = hc;
+    printf("checkRegistry: %s\n", failures == 0 ? "ok" : "failed");
+    return failures == 0 ? 0 : 1;
+}
+
+// Bakes a Tiled JSON map into the binary format TileMap::loadTileMap maps directly.
+int convertMap(const char* src, const char* dst)
+{
+    TileMap map;
+    map.loadTileMap(src);
+    map.createTileCollider();
+    map.saveTileMapBinary(dst);
+    map.unloadTileMap();
+    return 0;
+}
+
+// usage: HaniwaSlayer [--headless <ticks>] [--input <script>] [--record <file>] [--replay <file>] [--map <file>] [--no-texture-cache] [--pack <file>] [--load-threads <n>] [--spawn <n>]
+//        HaniwaSlayer [--map <file>] --check-asset-cache
+//        HaniwaSlayer --check-registry
+//        HaniwaSlayer --convert-map <in.json> <out.map>
+//        HaniwaSlayer --make-pack [--lz4] <out.pack> <files...>
+int main(int argc, char** argv)
+{
+    gStartTime = SDL_GetPerformanceCounter();
+    TextureCache::decodeSettings.flipVertically = true;
 
     player.create();
     player.hitbox.x = -3.0F;
@@ -129,10 +392,99 @@ int main()
     appConfig.height = SCR_Y;
     appConfig.title = "Haniwa Slayer";
     appConfig.debug_gl = true;
+    appConfig.reportFramePacing = true;
+    bool headless = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc)
+        {
+            headless = true;
+            appConfig.headlessTicks = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc)
+        {
+            appConfig.inputScript = argv[++i];
+        }
+        else if (strcmp(argv[i], "--map") == 0 && i + 1 < argc)
+        {
+            gMapFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--check-asset-cache") == 0)
+        {
+            return checkAssetCache(gMapFile);
+        }
+        else if (strcmp(argv[i], "--check-registry") == 0)
+        {
+            return checkRegistry();
+        }
+        else if (strcmp(argv[i], "--convert-map") == 0 && i + 2 < argc)
+        {
+            return convertMap(argv[i + 1], argv[i + 2]);
+        }
+        else if (strcmp(argv[i], "--pack") == 0 && i + 1 < argc)
+        {
+            if (!gAssetPack.openAssetPack(argv[++i]))
+            {
+                return 1;
+            }
+            AssetPack::current = &gAssetPack;
+        }
+        else if (strcmp(argv[i], "--make-pack") == 0 && i + 2 < argc)
+        {
+            bool compress = strcmp(argv[i + 1], "--lz4") == 0;
+            int first = compress ? i + 3 : i + 2;
+            if (first >= argc)
+            {
+                printf("--make-pack: no input files\n");
+                return 1;
+            }
+            return AssetPack::writeAssetPack(argv[first - 1], argv + first, size_t(argc - first), compress) ? 0 : 1;
+        }
+        else if (strcmp(argv[i], "--spawn") == 0 && i + 1 < argc)
+        {
+            gNumCrawlers = uint32_t(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--load-threads") == 0 && i + 1 < argc)
+        {
+            gLoadThreads = uint32_t(strtoul(argv[++i], nullptr, 10));
+        }
+        else if (strcmp(argv[i], "--no-texture-cache") == 0)
+        {
+            TextureCache::enabled = false;
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            appConfig.recordFile = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            appConfig.replayFile = argv[++i];
+        }
+        else
+        {
+            printf("unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
     GameApp app = {};
+    app.onInitSimulation = onInitSimulation;
     app.onInit = onInit;
     app.onUpdate = onUpdate;
+    app.onFixedUpdate = onFixedUpdate;
+    app.onRender = onRender;
     app.onShutdown = onShutdown;
-    runGameApp(app, appConfig);
+    app.onHashState = onHashState;
+    if (headless)
+    {
+        runHeadlessGameApp(app, appConfig);
+    }
+    else
+    {
+        runGameApp(app, appConfig);
+    }
+    if (AssetPack::current)
+    {
+        gAssetPack.closeAssetPack();
+    }
     return 0;
 }
@@ -0,0 +1,96 @@
+#include "mapped_file.hpp"
+#include <cassert>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+bool MappedFile::openMappedFile(const char* fileName)
+{
+    assert(!data);
+    HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = (uint8_t*)view;
+    size = size_t(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::closeMappedFile()
+{
+    assert(data);
+    UnmapViewOfFile(data);
+    CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+    data = nullptr;
+    size = 0;
+    fileHandle = nullptr;
+    mappingHandle = nullptr;
+}
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool MappedFile::openMappedFile(const char* fileName)
+{
+    assert(!data);
+    int file = open(fileName, O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(file, &st) != 0 || st.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+    void* view = mmap(nullptr, size_t(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED)
+    {
+        close(file);
+        return false;
+    }
+    fd = file;
+    data = (uint8_t*)view;
+    size = size_t(st.st_size);
+    return true;
+}
+
+void MappedFile::closeMappedFile()
+{
+    assert(data);
+    munmap(data, size);
+    close(fd);
+    data = nullptr;
+    size = 0;
+    fd = -1;
+}
+#endif
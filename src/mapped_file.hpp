@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Read-only file contents mapped into memory. The pages are copy-on-write, so
+// the mapping may be modified in place without touching the file.
+struct MappedFile {
+    uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    bool openMappedFile(const char* fileName);
+    void closeMappedFile();
+
+    bool isOpen() const
+    {
+        return data != nullptr;
+    }
+};
@@ -3,6 +3,7 @@
 #include "entity.hpp"
 #include "game_app.hpp"
 #include "sprite_sheet.hpp"
+#include "asset_cache.hpp"
 #include "helper.hpp"
 #include <functional>
 #include <algorithm>
@@ -84,31 +85,44 @@ struct Player : Entity {
     int8_t coyoteTime = 0;
     Input input;
     PlayerSpriteSheet currentSpriteSheet = kPlayerSpriteSheetIdle;
-    Sprite sprites[kNumPlayerSpriteSheet];
+    Sprite* sprites[kNumPlayerSpriteSheet] = {nullptr};
     SpriteSheet sprSheets[kNumPlayerSpriteSheet];
 
+    // Shares the sprites through AssetCache::current. Each sheet is created once its sprite is uploaded.
     void onPreload() override
     {
-        if (!sprites[kPlayerSpriteSheetIdle].isLoaded())
+        PROFILE_SCOPE("Player::onPreload");
+        static const char* const fileNames[kNumPlayerSpriteSheet] = {"playerIdle.png", "playerRun.png", "playerJump.png"};
+        static const uint32_t frameRates[kNumPlayerSpriteSheet] = {1, 4, 1};
+        assert(AssetCache::current);
+        for (int i = 0; i < kNumPlayerSpriteSheet; ++i)
         {
-            sprites[kPlayerSpriteSheetIdle].loadSprite("playerIdle.png");
-            sprSheets[kPlayerSpriteSheetIdle].createSpriteSheet(sprites[kPlayerSpriteSheetIdle], 32, 32, 1);
-        }
-        if (!sprites[kPlayerSpriteSheetRun].isLoaded())
-        {
-            sprites[kPlayerSpriteSheetRun].loadSprite("playerRun.png");
-            sprSheets[kPlayerSpriteSheetRun].createSpriteSheet(sprites[kPlayerSpriteSheetRun], 32, 32, 4);
+            if (!sprites[i])
+            {
+                sprites[i] = AssetCache::current->acquireSprite(fileNames[i], this, [this, i]() {
+                    if (sprites[i])
+                    {
+                        sprSheets[i].createSpriteSheet(*sprites[i], 32, 32, frameRates[i]);
+                    }
+                });
+            }
         }
-        if (!sprites[kPlayerSpriteSheetJump].isLoaded())
+    }
+
+    void onUnload() override
+    {
+        for (Sprite*& sprite : sprites)
         {
-            sprites[kPlayerSpriteSheetJump].loadSprite("playerJump.png");
-            sprSheets[kPlayerSpriteSheetJump].createSpriteSheet(sprites[kPlayerSpriteSheetJump], 32, 32, 1);
+            if (sprite)
+            {
+                AssetCache::current->releaseSprite(sprite, this);
+                sprite = nullptr;
+            }
         }
     }
 
     void create()
     {
-        id = Entity::genID();
         addEntity(this);
     }
 
@@ -119,17 +133,18 @@ struct Player : Entity {
 
     void update()
     {
+        PROFILE_SCOPE("Player::update");
         hsp = input.x * walksp;
 
-        moveX(hsp, [this](Entity* e) {
+        moveX(hsp, [this](const Contact& c) {
             if (hsp > 0.0F)
             {
-                Rect r = e->getHitArea();
+                const Rect& r = c.area;
                 position.x = r.x - hitbox.x - hitbox.w;
             }
             else if (hsp < 0.0F)
             {
-                Rect r = e->getHitArea();
+                const Rect& r = c.area;
                 position.x = r.x + r.w - hitbox.x;
             }
             hsp = 0.0F;
@@ -154,15 +169,15 @@ struct Player : Entity {
             vsp = 4.0F;
         }
 
-        moveY(vsp, [this](Entity* e) {
+        moveY(vsp, [this](const Contact& c) {
             if (vsp > 0.0F)
             {
-                Rect r = e->getHitArea();
+                const Rect& r = c.area;
                 position.y = r.y - hitbox.h;
             }
             else if (vsp < 0.0F)
             {
-                Rect r = e->getHitArea();
+                const Rect& r = c.area;
                 position.y = r.y + r.h - hitbox.y;
             }
             vsp = 0.0F;
@@ -192,23 +207,29 @@ struct Player : Entity {
         }
 
         sprSheets[currentSpriteSheet].update();
-        sprSheets[currentSpriteSheet].drawFrame(floorf(position.x), floorf(position.y), 0.0F, direction < 0.0F);
+    }
+
+    void draw(float alpha)
+    {
+        if (!sprites[currentSpriteSheet] || !sprites[currentSpriteSheet]->isLoaded())
+        {
+            return;
+        }
+        Vector3 pos = getRenderPosition(alpha);
+        sprSheets[currentSpriteSheet].drawFrame(floorf(pos.x), floorf(pos.y), 0.0F, direction < 0.0F);
     }
 
     bool onGround()
     {
-        for (Entity* e : Entity::entities)
+        Rect hurtbox = Rect(hitbox.x + position.x, hitbox.y + position.y - 0.00001F, hitbox.w, hitbox.h);
+        queryEntities(hurtbox, queryScratch);
+        for (Entity* e : queryScratch)
         {
-            if (id == e->id)
-            {
-                continue;
-            }
-            Rect hurtbox = Rect(hitbox.x + position.x, hitbox.y + position.y - 0.00001F, hitbox.w, hitbox.h);
-            if (hurtbox.isHit(e->getHitArea()))
+            if (handle != e->handle)
             {
                 return true;
             }
         }
-        return false;
+        return tileCollider && tileCollider->isHit(hurtbox);
     }
 };
@@ -0,0 +1,55 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <cstdio>
+
+
+std::mutex Profiler::mutex;
+
+std::vector<ProfileBuffer*> Profiler::buffers;
+
+uint64_t Profiler::startTime = SDL_GetPerformanceCounter();
+
+void Profiler::writeChromeTrace(const char* fileName)
+{
+    FILE* fp = fopen(fileName, "wb");
+    if (!fp)
+    {
+        printf("writeChromeTrace: failed to open %s\n", fileName);
+        return;
+    }
+
+    double usPerTick = 1000000.0 / double(SDL_GetPerformanceFrequency());
+    size_t numEvents = 0;
+    fprintf(fp, "{\"traceEvents\":[\n");
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<ProfileEvent> events;
+    for (ProfileBuffer* buffer : buffers)
+    {
+        // copy the newest events, oldest first, while the owner may keep pushing.
+        uint64_t end = buffer->count.load(std::memory_order_acquire);
+        uint64_t begin = end > ProfileBuffer::kCapacity ? end - ProfileBuffer::kCapacity : 0;
+        events.clear();
+        for (uint64_t n = begin; n < end; ++n)
+        {
+            events.push_back(buffer->slots[n & (ProfileBuffer::kCapacity - 1)].load());
+        }
+        // keeps the copy above from moving past the re-read of count. slots the owner
+        // reused during the copy, or is writing right now, may be torn. drop them.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = buffer->count.load(std::memory_order_relaxed) + 1;
+        size_t numTorn = after > begin + ProfileBuffer::kCapacity ? size_t(std::min(after - begin - ProfileBuffer::kCapacity, end - begin)) : 0;
+        for (size_t i = numTorn; i < events.size(); ++i)
+        {
+            const ProfileEvent& e = events[i];
+            fprintf(fp, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    numEvents > 0 ? ",\n" : "", e.name, buffer->threadID,
+                    double(e.start - startTime) * usPerTick, double(e.end - e.start) * usPerTick);
+            numEvents++;
+        }
+    }
+
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+    printf("writeChromeTrace: %s, events: %zu\n", fileName, numEvents);
+}
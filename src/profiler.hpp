@@ -0,0 +1,111 @@
+#pragma once
+
+#include <SDL.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Scoped CPU zone profiler. Build with HANIWA_PROFILE to enable the macros;
+// otherwise they compile to nothing. Each thread records into its own ring
+// buffer without locking and writeChromeTrace exports all of them as Chrome
+// trace_event JSON, loadable in chrome://tracing or Perfetto.
+
+struct ProfileEvent {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+// An event as stored in a ProfileBuffer. The fields are atomics so the exporter
+// can read a slot while its owner overwrites it. Relaxed, since count orders them.
+struct ProfileSlot {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> start{0};
+    std::atomic<uint64_t> end{0};
+
+    void store(const ProfileEvent& e)
+    {
+        name.store(e.name, std::memory_order_relaxed);
+        start.store(e.start, std::memory_order_relaxed);
+        end.store(e.end, std::memory_order_relaxed);
+    }
+
+    ProfileEvent load() const
+    {
+        return {name.load(std::memory_order_relaxed), start.load(std::memory_order_relaxed), end.load(std::memory_order_relaxed)};
+    }
+};
+
+// Single-writer ring buffer. Only the owning thread pushes. The exporter reads
+// count to find the newest kCapacity events, seqlock style: a slot copied while
+// count says it may have been reused is discarded.
+struct ProfileBuffer {
+    static constexpr size_t kCapacity = 1 << 16;
+    static_assert((kCapacity & (kCapacity - 1)) == 0, "kCapacity is a power of two");
+
+    std::vector<ProfileSlot> slots;
+    // events ever pushed. event n lives in slot n % kCapacity until overwritten.
+    std::atomic<uint64_t> count{0};
+    uint32_t threadID = 0;
+
+    ProfileBuffer() : slots(kCapacity) {}
+
+    void push(const ProfileEvent& e)
+    {
+        uint64_t n = count.load(std::memory_order_relaxed);
+        // an exporter that sees any of the stores below also sees count >= n.
+        std::atomic_thread_fence(std::memory_order_release);
+        slots[n & (kCapacity - 1)].store(e);
+        count.store(n + 1, std::memory_order_release);
+    }
+};
+
+struct Profiler {
+    static std::mutex mutex;
+    static std::vector<ProfileBuffer*> buffers;
+    static uint64_t startTime;
+
+    static ProfileBuffer& getThreadBuffer()
+    {
+        thread_local ProfileBuffer* buffer = nullptr;
+        if (!buffer)
+        {
+            // buffers are never freed so events from exited threads can still be exported.
+            buffer = new ProfileBuffer();
+            std::lock_guard<std::mutex> lock(mutex);
+            buffer->threadID = uint32_t(buffers.size());
+            buffers.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    static void writeChromeTrace(const char* fileName);
+};
+
+struct ProfileScope {
+    const char* name;
+    uint64_t start;
+
+    explicit ProfileScope(const char* name) : name(name), start(SDL_GetPerformanceCounter()) {}
+
+    ~ProfileScope()
+    {
+        Profiler::getThreadBuffer().push({name, start, SDL_GetPerformanceCounter()});
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#if defined(HANIWA_PROFILE)
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_WRITE_TRACE(fileName) Profiler::writeChromeTrace(fileName)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_WRITE_TRACE(fileName) ((void)0)
+#endif
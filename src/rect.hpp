@@ -0,0 +1,23 @@
+#pragma once
+
+struct Rect {
+    float x, y, w, h;
+
+    Rect()
+    {
+        x = 0.0F;
+        y = 0.0F;
+        w = 0.0F;
+        h = 0.0F;
+    }
+
+    Rect(float x, float y, float w, float h) : x(x), y(y), w(w), h(h) {}
+
+    bool isHit(const Rect& other) const
+    {
+        return (x + w > other.x &&
+                y + h > other.y &&
+                x < other.x + other.w &&
+                y < other.y + other.h);
+    }
+};
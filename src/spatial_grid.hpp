@@ -0,0 +1,100 @@
+#pragma once
+
+#include "rect.hpp"
+#include <cstdint>
+#include <cmath>
+#include <cassert>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+// Inclusive range of grid cells an area is bucketed into.
+struct GridRange {
+    int32_t minX = 0;
+    int32_t minY = 0;
+    int32_t maxX = -1;
+    int32_t maxY = -1;
+
+    bool isEmpty() const
+    {
+        return maxX < minX || maxY < minY;
+    }
+
+    bool operator==(const GridRange& other) const
+    {
+        return minX == other.minX && minY == other.minY && maxX == other.maxX && maxY == other.maxY;
+    }
+
+    bool operator!=(const GridRange& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// Uniform grid broadphase. Entities are bucketed by registry slot index into every
+// cell their hit area touches.
+struct SpatialGrid {
+    float cellSize = 32.0F;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+
+    static uint64_t cellKey(int32_t cx, int32_t cy)
+    {
+        return (uint64_t(uint32_t(cx)) << 32) | uint64_t(uint32_t(cy));
+    }
+
+    GridRange computeRange(const Rect& area) const
+    {
+        GridRange r;
+        r.minX = int32_t(floorf(area.x / cellSize));
+        r.minY = int32_t(floorf(area.y / cellSize));
+        r.maxX = int32_t(floorf((area.x + area.w) / cellSize));
+        r.maxY = int32_t(floorf((area.y + area.h) / cellSize));
+        return r;
+    }
+
+    void insert(uint32_t slot, const GridRange& range)
+    {
+        for (int32_t cy = range.minY; cy <= range.maxY; ++cy)
+        {
+            for (int32_t cx = range.minX; cx <= range.maxX; ++cx)
+            {
+                cells[cellKey(cx, cy)].push_back(slot);
+            }
+        }
+    }
+
+    void remove(uint32_t slot, const GridRange& range)
+    {
+        for (int32_t cy = range.minY; cy <= range.maxY; ++cy)
+        {
+            for (int32_t cx = range.minX; cx <= range.maxX; ++cx)
+            {
+                auto it = cells.find(cellKey(cx, cy));
+                assert(it != cells.end());
+                std::vector<uint32_t>& cell = it->second;
+                auto found = std::find(cell.begin(), cell.end(), slot);
+                assert(found != cell.end());
+                *found = cell.back();
+                cell.pop_back();
+            }
+        }
+    }
+
+    // Appends every slot bucketed in a cell touched by area. An entity spanning
+    // several cells is appended once per cell.
+    void query(const Rect& area, std::vector<uint32_t>& out) const
+    {
+        GridRange range = computeRange(area);
+        for (int32_t cy = range.minY; cy <= range.maxY; ++cy)
+        {
+            for (int32_t cx = range.minX; cx <= range.maxX; ++cx)
+            {
+                auto it = cells.find(cellKey(cx, cy));
+                if (it != cells.end())
+                {
+                    out.insert(out.end(), it->second.begin(), it->second.end());
+                }
+            }
+        }
+    }
+};
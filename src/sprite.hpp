@@ -1,10 +1,23 @@
 #pragma once
 
 #include "gmath.hpp"
+#include "sprite_batch.hpp"
+#include "profiler.hpp"
+#include "sprite_image.hpp"
+#include "byte_span.hpp"
+#include "texture_cache.hpp"
+#include "hash.hpp"
 #include "glad.h"
 #include "stb_image.h"
+#include <SDL.h>
 #include <cstdint>
 #include <cassert>
+#include <string>
+
+struct SpriteFrame {
+    float uvX, uvY, uvW, uvH;
+    uint16_t width, height;
+};
 
 struct Sprite {
     Sprite* parent = nullptr;
@@ -21,24 +34,90 @@ struct Sprite {
 
     void loadSprite(const char* fileName)
     {
-        assert(texID == 0);
+        PROFILE_SCOPE("Sprite::loadSprite");
+        SpriteImage image = decodeSprite(fileName);
+        uploadSprite(image);
+        freeSpriteImage(image);
+    }
+
+    // Decodes PNG bytes already in memory, e.g. an AssetPack entry. name and
+    // assetRoot locate its texture cache blob, see TextureCache::makeKey.
+    void loadSpriteFromMemory(ByteSpan png, const char* name, const std::string& assetRoot)
+    {
+        PROFILE_SCOPE("Sprite::loadSpriteFromMemory");
+        SpriteImage image = decodeSpriteFromMemory(png, name, assetRoot);
+        uploadSprite(image);
+        freeSpriteImage(image);
+    }
 
-        int x, y, c;
-        stbi_uc* buffer = stbi_load(fileName, &x, &y, &c, 0);
-        assert(buffer);
-        assert(c == 4);
+    // No GL, so it may run on any thread.
+    static SpriteImage decodeSprite(const char* fileName)
+    {
+        MappedFile png;
+        png.openMappedFile(fileName);
+        assert(png.isOpen());
+        SpriteImage image = decodeSpriteFromMemory({png.data, png.size}, fileName, TextureCache::getAssetRoot(fileName));
+        png.closeMappedFile();
+        return image;
+    }
+
+    // Maps the decoded pixels from the texture cache when the PNG's content has
+    // been seen before with the same TextureCache::decodeSettings.
+    static SpriteImage decodeSpriteFromMemory(ByteSpan png, const char* name, const std::string& assetRoot)
+    {
+        PROFILE_SCOPE("Sprite::decodeSprite");
+        uint64_t startTime = SDL_GetPerformanceCounter();
+        TextureCacheKey key = TextureCache::makeKey(assetRoot, name, fnv1a64(png.data, png.size));
+        assert(key.settings.channels == 4);
+
+        SpriteImage image;
+        bool cached = TextureCache::loadCachedImage(key, image);
+        if (!cached)
+        {
+            int x, y, c;
+            // per thread, since decodes run on the loader's workers.
+            stbi_set_flip_vertically_on_load_thread(key.settings.flipVertically ? 1 : 0);
+            stbi_uc* buffer = stbi_load_from_memory(png.data, int(png.size), &x, &y, &c, key.settings.channels);
+            assert(buffer);
+            image.pixels = buffer;
+            image.width = uint16_t(x);
+            image.height = uint16_t(y);
+            TextureCache::storeCachedImage(key, image);
+        }
+        printf("loadSprite: %s, width: %d, height: %d, %s, %.3f ms\n", name, image.width, image.height, cached ? "cached" : "decoded",
+               double(SDL_GetPerformanceCounter() - startTime) * 1000.0 / SDL_GetPerformanceFrequency());
+        return image;
+    }
+
+    static void freeSpriteImage(SpriteImage& image)
+    {
+        if (image.mapped.isOpen())
+        {
+            image.mapped.closeMappedFile();
+        }
+        else
+        {
+            stbi_image_free(image.pixels);
+        }
+        image.pixels = nullptr;
+    }
+
+    // Creates the texture from decoded RGBA pixels. needs the GL context.
+    void uploadSprite(const SpriteImage& image)
+    {
+        PROFILE_SCOPE("Sprite::uploadSprite");
+        assert(texID == 0);
+        assert(image.pixels);
 
         glGenTextures(1, &texID);
         glBindTexture(GL_TEXTURE_2D, texID);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, (const void*)buffer);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, (const void*)image.pixels);
         glBindTexture(GL_TEXTURE_2D, 0);
 
-        width = x;
-        height = y;
-        stbi_image_free(buffer);
-        printf("loadSprite: %s, width: %d, height: %d\n", fileName, x, y);
+        width = image.width;
+        height = image.height;
     }
 
     void unloadSprite()
@@ -62,54 +141,95 @@ struct Sprite {
         height = h;
     }
 
-    void drawSprite(float x, float y, float angleRad = 0.0F, bool flipX = false, bool flipY = false) const
+    GLuint getTexID() const
+    {
+        return parent ? parent->texID : texID;
+    }
+
+    // texture rect and pixel size, everything needed to place the sprite's quad.
+    SpriteFrame getFrame() const
     {
-        float uvX = 0.0F, uvW = 1.0F;
-        float uvY = 0.0F, uvH = 1.0F;
+        SpriteFrame f;
+        f.uvX = 0.0F;
+        f.uvY = 0.0F;
+        f.uvW = 1.0F;
+        f.uvH = 1.0F;
         if (parent)
         {
-            uvX = float(srcX) / float(parent->width);
-            uvY = float(srcY) / float(parent->height);
-            uvW = (uvX + float(width)) / float(parent->width);
-            uvH = (uvY + float(height)) / float(parent->height);
+            f.uvX = float(srcX) / float(parent->width);
+            f.uvY = float(srcY) / float(parent->height);
+            f.uvW = (f.uvX + float(width)) / float(parent->width);
+            f.uvH = (f.uvY + float(height)) / float(parent->height);
         }
-        // CCW 2 triangle. top-right as first vtx.
-        const Vector4 _pos[6] = {
-            //x, y, z, w
-            {0.5F, 0.5F, 0.0F, 1.0F},
-            {-0.5F, 0.5F, 0.0F, 1.0F},
-            {-0.5F, -0.5F, 0.0F, 1.0F},
-            {-0.5F, -0.5F, 0.0F, 1.0F},
-            {0.5F, -0.5F, 0.0F, 1.0F},
-            {0.5F, 0.5F, 0.0F, 1.0F}};
-        const Vector3 texCoords[6] = {
-            {uvX + uvW, uvY + uvH, 0.0F},
-            {uvX, uvY + uvH, 0.0F},
-            {uvX, uvY, 0.0F},
-            {uvX, uvY, 0.0F},
-            {uvX + uvW, uvY, 0.0F},
-            {uvX + uvW, uvY + uvH, 0.0F}};
-
-        Vector4 pos[6];
-        Matrix4 S = mat4CreateScale(vec3(flipX ? -width : width, flipY ? -height : height, 0.0F));
-        Matrix4 R = mat4CreateFromAxisAngle(vec3(0.0F, 0.0F, 1.0F), angleRad);
-        Matrix4 T = mat4CreateTranslation(vec3(x, y, 0.0F));
-        Matrix4 xform = mat4Multiply(mat4Multiply(S, R), T);
-        for (int i = 0; i < 6; ++i)
+        f.width = width;
+        f.height = height;
+        return f;
+    }
+
+    void drawSprite(float x, float y, float angleRad = 0.0F, bool flipX = false, bool flipY = false) const
+    {
+        submitFrame(getTexID(), getFrame(), x, y, angleRad, flipX, flipY);
+    }
+
+    void buildQuad(SpriteBatch::Vertex quad[4], float x, float y, float angleRad = 0.0F, bool flipX = false, bool flipY = false) const
+    {
+        buildFrameQuad(quad, getFrame(), x, y, angleRad, flipX, flipY);
+    }
+
+    static void submitFrame(GLuint tex, const SpriteFrame& f, float x, float y, float angleRad = 0.0F, bool flipX = false, bool flipY = false)
+    {
+        assert(SpriteBatch::current);
+
+        // half the diagonal bounds the quad at any rotation.
+        float hw = f.width / 2.0F;
+        float hh = f.height / 2.0F;
+        if (angleRad != 0.0F)
+        {
+            hw = hh = sqrtf(hw * hw + hh * hh);
+        }
+        if (!SpriteBatch::current->isVisible(Rect(x - hw, y - hh, hw * 2.0F, hh * 2.0F)))
+        {
+            return;
+        }
+
+        SpriteBatch::Vertex quad[4];
+        buildFrameQuad(quad, f, x, y, angleRad, flipX, flipY);
+        SpriteBatch::current->drawQuad(tex, quad);
+    }
+
+    // quad is top-right, top-left, bottom-left, bottom-right before rotation.
+    static void buildFrameQuad(SpriteBatch::Vertex quad[4], const SpriteFrame& f, float x, float y, float angleRad = 0.0F, bool flipX = false, bool flipY = false)
+    {
+        const Vector2 _pos[4] = {
+            {0.5F, 0.5F},
+            {-0.5F, 0.5F},
+            {-0.5F, -0.5F},
+            {0.5F, -0.5F}};
+        const Vector2 texCoords[4] = {
+            {f.uvX + f.uvW, f.uvY + f.uvH},
+            {f.uvX, f.uvY + f.uvH},
+            {f.uvX, f.uvY},
+            {f.uvX + f.uvW, f.uvY}};
+
+        float sx = flipX ? -float(f.width) : float(f.width);
+        float sy = flipY ? -float(f.height) : float(f.height);
+        if (angleRad == 0.0F)
         {
-            pos[i] = vec4Transform(_pos[i], xform);
+            for (int i = 0; i < 4; ++i)
+            {
+                quad[i] = {_pos[i].x * sx + x, _pos[i].y * sy + y, texCoords[i].x, texCoords[i].y};
+            }
+            return;
         }
 
-        glBindTexture(GL_TEXTURE_2D, parent ? parent->texID : texID);
-        glBegin(GL_TRIANGLES);
-        for (int i = 0; i < 6; ++i)
+        Matrix3x2 S = mat3x2CreateScale(vec2(sx, sy));
+        Matrix3x2 R = mat3x2CreateRotation(angleRad);
+        Matrix3x2 T = mat3x2CreateTranslation(vec2(x, y));
+        Matrix3x2 xform = mat3x2Multiply(mat3x2Multiply(S, R), T);
+        for (int i = 0; i < 4; ++i)
         {
-            Vector3 t = texCoords[i];
-            Vector4 p = pos[i];
-            glTexCoord2f(t.x, t.y);
-            glVertex3f(p.x, p.y, p.z);
+            Vector2 p = vec2Transform(_pos[i], xform);
+            quad[i] = {p.x, p.y, texCoords[i].x, texCoords[i].y};
         }
-        glEnd();
-        glBindTexture(GL_TEXTURE_2D, 0);
     }
 };
@@ -0,0 +1,4 @@
+#include "sprite_batch.hpp"
+
+
+SpriteBatch* SpriteBatch::current = nullptr;
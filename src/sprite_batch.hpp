@@ -0,0 +1,157 @@
+#pragma once
+
+#include "glad.h"
+#include "rect.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+// Collects textured quads into a CPU vertex array and draws each run of
+// quads sharing a texture with a single streamed VBO draw.
+struct SpriteBatch {
+    struct Vertex {
+        float x, y;
+        float u, v;
+    };
+
+    static SpriteBatch* current;
+
+    std::vector<Vertex> vertices;
+    GLuint vbo = 0;
+    GLuint texID = 0;
+    uint32_t numSprites = 0;
+    uint32_t numDrawCalls = 0;
+    uint32_t prevNumSprites = 0;
+    uint32_t prevNumDrawCalls = 0;
+    bool cull = false;
+    Rect view;
+
+    void createSpriteBatch(uint32_t maxSprites = 4096)
+    {
+        assert(!vbo);
+
+        glGenBuffers(1, &vbo);
+        assert(vbo);
+        vertices.reserve(maxSprites * 6);
+    }
+
+    void destroySpriteBatch()
+    {
+        assert(vbo);
+        assert(current != this);
+        glDeleteBuffers(1, &vbo);
+        vbo = 0;
+        vertices.clear();
+    }
+
+    void begin()
+    {
+        assert(vbo);
+        assert(current == nullptr);
+        current = this;
+        numSprites = 0;
+        numDrawCalls = 0;
+        cull = false;
+    }
+
+    // Quads outside view are skipped by callers that check isVisible.
+    void begin(const Rect& viewRect)
+    {
+        begin();
+        cull = true;
+        view = viewRect;
+    }
+
+    bool isVisible(const Rect& area) const
+    {
+        return !cull || view.isHit(area);
+    }
+
+    void end()
+    {
+        assert(current == this);
+        flush();
+        current = nullptr;
+    }
+
+    void reportDrawCalls()
+    {
+        if (numSprites != prevNumSprites || numDrawCalls != prevNumDrawCalls)
+        {
+            printf("SpriteBatch: sprites: %u (unbatched draw calls: %u), batched draw calls: %u\n", numSprites, numSprites, numDrawCalls);
+        }
+        prevNumSprites = numSprites;
+        prevNumDrawCalls = numDrawCalls;
+    }
+
+    // quad is top-right, top-left, bottom-left, bottom-right.
+    void drawQuad(GLuint tex, const Vertex quad[4])
+    {
+        if (tex != texID)
+        {
+            flush();
+            texID = tex;
+        }
+
+        appendQuad(vertices, quad);
+        numSprites++;
+    }
+
+    // CCW 2 triangle. top-right as first vtx.
+    static void appendQuad(std::vector<Vertex>& out, const Vertex quad[4])
+    {
+        out.push_back(quad[0]);
+        out.push_back(quad[1]);
+        out.push_back(quad[2]);
+        out.push_back(quad[2]);
+        out.push_back(quad[3]);
+        out.push_back(quad[0]);
+    }
+
+    // Draws count vertices from a prebuilt static buffer in the same vertex format.
+    void drawBuffer(GLuint buffer, GLuint tex, GLint first, GLsizei count)
+    {
+        flush();
+
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        drawArrays(tex, first, count);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        numSprites += uint32_t(count / 6);
+        numDrawCalls++;
+    }
+
+    void flush()
+    {
+        if (vertices.empty())
+        {
+            return;
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(vertices.size() * sizeof(Vertex)), vertices.data(), GL_STREAM_DRAW);
+        drawArrays(texID, 0, GLsizei(vertices.size()));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        vertices.clear();
+        numDrawCalls++;
+    }
+
+    // Draws from the bound GL_ARRAY_BUFFER.
+    static void drawArrays(GLuint tex, GLint first, GLsizei count)
+    {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glVertexPointer(2, GL_FLOAT, sizeof(Vertex), (const void*)offsetof(Vertex, x));
+        glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), (const void*)offsetof(Vertex, u));
+
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glDrawArrays(GL_TRIANGLES, first, count);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+    }
+};
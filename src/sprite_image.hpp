@@ -0,0 +1,13 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include <cstdint>
+
+// Decoded RGBA pixels waiting to be uploaded as a texture. pixels is either
+// owned by stb_image or points into mapped, a texture cache blob.
+struct SpriteImage {
+    uint8_t* pixels = nullptr;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    MappedFile mapped;
+};
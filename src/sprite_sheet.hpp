@@ -3,6 +3,7 @@
 #include "sprite.hpp"
 #include <cstdint>
 #include <cmath>
+#include <vector>
 
 struct SpriteSheet {
     Sprite* source = nullptr;
@@ -14,6 +15,7 @@ struct SpriteSheet {
     uint32_t frameIndex = 0;
     uint32_t _i = 0;
     uint32_t frameRate = 0;
+    std::vector<SpriteFrame> frames;
 
     void createSpriteSheet(Sprite& source, uint16_t frameWidth, uint16_t frameHeight, uint32_t frameRate)
     {
@@ -25,6 +27,18 @@ struct SpriteSheet {
         this->frameWidth = frameWidth;
         this->frameHeight = frameHeight;
         this->frameRate = frameRate;
+
+        frames.clear();
+        frames.reserve(frameMax);
+        for (uint16_t y = 0; y < rows; ++y)
+        {
+            for (uint16_t x = 0; x < columns; ++x)
+            {
+                Sprite spr;
+                spr.loadSubSprite(source, frameWidth * x, frameHeight * y, frameWidth, frameHeight);
+                frames.push_back(spr.getFrame());
+            }
+        }
     }
 
     void reset()
@@ -51,12 +65,6 @@ struct SpriteSheet {
     {
         assert(frameIndex < frameMax);
 
-        uint16_t x = frameIndex % columns;
-        uint16_t y = floorf(frameIndex / float(columns));
-        float sx = frameWidth * float(x);
-        float sy = frameHeight * float(y);
-        Sprite spr;
-        spr.loadSubSprite(*source, sx, sy, frameWidth, frameHeight);
-        spr.drawSprite(dx, dy, radAngle, flipX, flipY);
+        Sprite::submitFrame(source->getTexID(), frames[frameIndex], dx, dy, radAngle, flipX, flipY);
     }
 };
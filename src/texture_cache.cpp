@@ -0,0 +1,117 @@
+#include "texture_cache.hpp"
+#include "hash.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <thread>
+
+const char* TextureCache::directory = nullptr;
+bool TextureCache::enabled = true;
+TextureDecodeSettings TextureCache::decodeSettings;
+
+struct TextureCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t contentHash;
+    uint32_t width;
+    uint32_t height;
+    uint8_t flipVertically;
+    uint8_t channels;
+    uint16_t reserved0;
+    uint32_t reserved1;
+};
+static_assert(sizeof(TextureCacheHeader) == 32, "TextureCacheHeader has no implicit padding");
+
+TextureCacheKey TextureCache::makeKey(const std::string& assetRoot, const char* name, uint64_t contentHash)
+{
+    std::filesystem::path dir = directory ? std::filesystem::path(directory) : std::filesystem::path(assetRoot) / "texcache";
+    char blobName[32];
+    snprintf(blobName, sizeof(blobName), "%016llx.tex", (unsigned long long)fnv1a64(name, strlen(name)));
+    TextureCacheKey key;
+    key.path = (dir / blobName).string();
+    key.contentHash = contentHash;
+    key.settings = decodeSettings;
+    return key;
+}
+
+std::string TextureCache::getAssetRoot(const char* fileName)
+{
+    return std::filesystem::path(fileName).parent_path().string();
+}
+
+bool TextureCache::loadCachedImage(const TextureCacheKey& key, SpriteImage& image)
+{
+    if (!enabled)
+    {
+        return false;
+    }
+    MappedFile file;
+    if (!file.openMappedFile(key.path.c_str()))
+    {
+        return false;
+    }
+
+    const TextureCacheHeader* header = (const TextureCacheHeader*)file.data;
+    bool valid = file.size >= sizeof(TextureCacheHeader) && memcmp(header->magic, "HNTX", 4) == 0 && header->version == kVersion &&
+                 file.size == sizeof(TextureCacheHeader) + size_t(header->width) * header->height * header->channels;
+    if (!valid)
+    {
+        printf("TextureCache: ignoring invalid blob %s\n", key.path.c_str());
+        file.closeMappedFile();
+        return false;
+    }
+    // the asset changed or is decoded differently now. storeCachedImage replaces the blob.
+    if (header->contentHash != key.contentHash || header->flipVertically != uint8_t(key.settings.flipVertically) ||
+        header->channels != key.settings.channels)
+    {
+        file.closeMappedFile();
+        return false;
+    }
+
+    image.width = uint16_t(header->width);
+    image.height = uint16_t(header->height);
+    image.pixels = file.data + sizeof(TextureCacheHeader);
+    image.mapped = file;
+    return true;
+}
+
+void TextureCache::storeCachedImage(const TextureCacheKey& key, const SpriteImage& image)
+{
+    if (!enabled)
+    {
+        return;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(key.path).parent_path(), ec);
+
+    // write under a per-thread name and rename over the old blob, so a reader never maps a partial one.
+    std::string tmpPath = key.path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    FILE* fp = fopen(tmpPath.c_str(), "wb");
+    if (!fp)
+    {
+        printf("TextureCache: failed to open %s\n", tmpPath.c_str());
+        return;
+    }
+    TextureCacheHeader header = {};
+    memcpy(header.magic, "HNTX", 4);
+    header.version = kVersion;
+    header.contentHash = key.contentHash;
+    header.width = image.width;
+    header.height = image.height;
+    header.flipVertically = uint8_t(key.settings.flipVertically);
+    header.channels = key.settings.channels;
+    size_t size = size_t(image.width) * image.height * key.settings.channels;
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 && fwrite(image.pixels, 1, size, fp) == size;
+    ok = fclose(fp) == 0 && ok;
+    if (ok)
+    {
+        std::filesystem::rename(tmpPath, key.path, ec);
+        ok = !ec;
+    }
+    if (!ok)
+    {
+        std::filesystem::remove(tmpPath, ec);
+    }
+}
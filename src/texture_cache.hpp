@@ -0,0 +1,45 @@
+#pragma once
+
+#include "sprite_image.hpp"
+#include <cstdint>
+#include <string>
+
+// How Sprite decodes PNGs. Recorded in every blob, so a changed setting misses
+// instead of mapping pixels decoded the other way.
+struct TextureDecodeSettings {
+    bool flipVertically = false;
+    // channels stb_image converts to. uploadSprite only takes 4.
+    uint8_t channels = 4;
+};
+
+// Where a decoded image lives in the cache and what it must have been decoded from.
+struct TextureCacheKey {
+    std::string path;
+    uint64_t contentHash = 0;
+    TextureDecodeSettings settings;
+};
+
+// On-disk cache of decoded images. Each source asset has a single blob, named by
+// a hash of the asset's name, in a texcache directory next to the asset root.
+// The blob records the hash of the PNG's bytes and the decode settings, so an
+// edited PNG or a changed setting misses and its new blob replaces the old one.
+struct TextureCache {
+    // bump when the blob layout changes.
+    static constexpr uint32_t kVersion = 2;
+
+    // overrides the texcache directory under each asset root when set.
+    static const char* directory;
+    static bool enabled;
+    static TextureDecodeSettings decodeSettings;
+
+    // assetRoot is the directory the asset was loaded from: the PNG's own
+    // directory, or the directory of the pack holding it.
+    static TextureCacheKey makeKey(const std::string& assetRoot, const char* name, uint64_t contentHash);
+    // Directory containing fileName, for use as an asset root.
+    static std::string getAssetRoot(const char* fileName);
+
+    // Maps the blob for key into image. false on a miss.
+    static bool loadCachedImage(const TextureCacheKey& key, SpriteImage& image);
+    // Replaces the blob for key, so at most one blob per asset is kept.
+    static void storeCachedImage(const TextureCacheKey& key, const SpriteImage& image);
+};
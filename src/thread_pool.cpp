@@ -0,0 +1,72 @@
+#include "thread_pool.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+uint32_t ThreadPool::getDefaultThreadCount()
+{
+    uint32_t cores = std::thread::hardware_concurrency();
+    return std::max(cores, 2U) - 1;
+}
+
+void ThreadPool::createThreadPool(uint32_t numThreads)
+{
+    assert(threads.empty());
+    if (numThreads == 0)
+    {
+        numThreads = getDefaultThreadCount();
+    }
+    quit = false;
+    threads.reserve(numThreads);
+    for (uint32_t i = 0; i < numThreads; ++i)
+    {
+        threads.emplace_back(&ThreadPool::workerMain, this);
+    }
+    printf("createThreadPool: threads: %u\n", numThreads);
+}
+
+void ThreadPool::destroyThreadPool()
+{
+    assert(!threads.empty());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    cv.notify_all();
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    threads.clear();
+}
+
+void ThreadPool::submit(std::function<void()> job)
+{
+    assert(!threads.empty());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    cv.notify_one();
+}
+
+void ThreadPool::workerMain()
+{
+    for (;;)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]() { return quit || !jobs.empty(); });
+            if (jobs.empty())
+            {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+        PROFILE_SCOPE("ThreadPool::job");
+        job();
+    }
+}
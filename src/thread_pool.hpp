@@ -0,0 +1,33 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running submitted jobs in FIFO order.
+struct ThreadPool {
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool quit = false;
+
+    // one thread per core, leaving one for the main thread.
+    static uint32_t getDefaultThreadCount();
+
+    void createThreadPool(uint32_t numThreads = 0);
+    // runs the jobs already queued, then joins the threads.
+    void destroyThreadPool();
+    void submit(std::function<void()> job);
+
+    bool isCreated() const
+    {
+        return !threads.empty();
+    }
+
+    void workerMain();
+};
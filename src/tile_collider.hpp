@@ -0,0 +1,258 @@
+#pragma once
+
+#include "rect.hpp"
+#include <cassert>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+// A merged solid rect in tile units. Rows grow downwards from the top of the layer.
+struct TileRect {
+    uint16_t x, y, w, h;
+};
+
+// Answers overlap queries against the solid tiles of a tile layer by indexing
+// the layer with the tile range a rect covers, without any per-tile objects.
+// Solid tiles are greedily merged into larger rects, which are what queries report.
+struct TileCollider {
+    const uint8_t* tiles = nullptr;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint16_t tileWidth = 0;
+    uint16_t tileHeight = 0;
+    // world-space left edge of column 0 and top edge of row 0. rows grow downwards.
+    float left = 0.0F;
+    float top = 0.0F;
+    // merged rects in world space. may hold empty slots left by updateTile, so
+    // rects.size() is not the rect count. use getNumRects and forEachRect.
+    std::vector<Rect> rects;
+    // the same rects in tile units, as saved in binary maps. w is 0 for an empty slot.
+    std::vector<TileRect> tileRects;
+    // slots of rects removed by updateTile, left empty until reused.
+    std::vector<uint32_t> freeRects;
+    // per tile, index + 1 of the merged rect covering it. 0 for empty tiles.
+    std::vector<uint32_t> rectIndex;
+    // marks rects already reported by the current query.
+    mutable std::vector<uint32_t> rectStamp;
+    mutable uint32_t stamp = 0;
+
+    static bool isSolid(uint8_t idx)
+    {
+        return idx > 1;
+    }
+
+    bool isFree(int32_t tx, int32_t ty) const
+    {
+        return isSolid(tiles[size_t(width) * ty + tx]) && rectIndex[size_t(width) * ty + tx] == 0;
+    }
+
+    Rect getBounds() const
+    {
+        return {left, top - float(height * tileHeight), float(width * tileWidth), float(height * tileHeight)};
+    }
+
+    // Greedy meshing: grow each unassigned solid tile into the widest run, then
+    // extend it down while every tile in the next row's span is free and solid.
+    void build()
+    {
+        rects.clear();
+        tileRects.clear();
+        freeRects.clear();
+        rectIndex.assign(size_t(width) * height, 0);
+        meshRegion(0, 0, width, height);
+        rectStamp.assign(rects.size(), 0);
+        stamp = 0;
+    }
+
+    // Adopts merged rects saved from build(), e.g. by a binary map, and rebuilds
+    // rectIndex from them. Only touches the tiles the rects cover.
+    void assign(const TileRect* merged, uint32_t numRects)
+    {
+        rects.clear();
+        tileRects.clear();
+        freeRects.clear();
+        rects.reserve(numRects);
+        tileRects.reserve(numRects);
+        rectIndex.assign(size_t(width) * height, 0);
+        for (uint32_t i = 0; i < numRects; ++i)
+        {
+            assert(merged[i].x + merged[i].w <= width && merged[i].y + merged[i].h <= height);
+            addRect(merged[i]);
+        }
+        rectStamp.assign(rects.size(), 0);
+        stamp = 0;
+    }
+
+    // Call after tile (tx, ty) changed solidity. Only the merged rects covering the
+    // tile or its four neighbours are removed and re-meshed, so the cost is bounded
+    // by their area instead of the map's. The result covers the same tiles as
+    // build() would, though the rects may be split differently.
+    void updateTile(int32_t tx, int32_t ty)
+    {
+        assert(tx >= 0 && ty >= 0 && tx < width && ty < height);
+        int32_t x0 = tx;
+        int32_t y0 = ty;
+        int32_t x1 = tx + 1;
+        int32_t y1 = ty + 1;
+        static const int32_t kOffsets[5][2] = {{0, 0}, {-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+        for (const int32_t* o : kOffsets)
+        {
+            int32_t x = tx + o[0];
+            int32_t y = ty + o[1];
+            if (x < 0 || y < 0 || x >= width || y >= height)
+            {
+                continue;
+            }
+            uint32_t i = rectIndex[size_t(width) * y + x];
+            if (i == 0)
+            {
+                continue;
+            }
+            TileRect r = tileRects[i - 1];
+            x0 = std::min(x0, int32_t(r.x));
+            y0 = std::min(y0, int32_t(r.y));
+            x1 = std::max(x1, int32_t(r.x + r.w));
+            y1 = std::max(y1, int32_t(r.y + r.h));
+            removeRect(i - 1);
+        }
+        meshRegion(x0, y0, x1, y1);
+        rectStamp.resize(rects.size(), 0);
+    }
+
+    // Meshes the free solid tiles in [x0, x1) x [y0, y1), the same way build() does.
+    void meshRegion(int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+    {
+        for (int32_t ty = y0; ty < y1; ++ty)
+        {
+            for (int32_t tx = x0; tx < x1; ++tx)
+            {
+                if (!isFree(tx, ty))
+                {
+                    continue;
+                }
+                int32_t w = 1;
+                while (tx + w < x1 && isFree(tx + w, ty))
+                {
+                    w++;
+                }
+                int32_t h = 1;
+                for (; ty + h < y1; ++h)
+                {
+                    bool rowFree = true;
+                    for (int32_t x = tx; x < tx + w && rowFree; ++x)
+                    {
+                        rowFree = isFree(x, ty + h);
+                    }
+                    if (!rowFree)
+                    {
+                        break;
+                    }
+                }
+
+                addRect({uint16_t(tx), uint16_t(ty), uint16_t(w), uint16_t(h)});
+            }
+        }
+    }
+
+    // Reuses a slot freed by removeRect if there is one.
+    void addRect(const TileRect& r)
+    {
+        Rect area(left + float(r.x * tileWidth), top - float((r.y + r.h) * tileHeight), float(r.w * tileWidth), float(r.h * tileHeight));
+        uint32_t index;
+        if (!freeRects.empty())
+        {
+            index = freeRects.back();
+            freeRects.pop_back();
+            tileRects[index] = r;
+            rects[index] = area;
+        }
+        else
+        {
+            index = uint32_t(rects.size());
+            tileRects.push_back(r);
+            rects.push_back(area);
+        }
+        fillRectIndex(r, index + 1);
+    }
+
+    // Leaves an empty rect in the slot. Queries never reach it since no tile points at it.
+    void removeRect(uint32_t index)
+    {
+        fillRectIndex(tileRects[index], 0);
+        tileRects[index] = {0, 0, 0, 0};
+        rects[index] = Rect();
+        freeRects.push_back(index);
+    }
+
+    void fillRectIndex(const TileRect& r, uint32_t value)
+    {
+        for (int32_t y = r.y; y < r.y + r.h; ++y)
+        {
+            for (int32_t x = r.x; x < r.x + r.w; ++x)
+            {
+                rectIndex[size_t(width) * y + x] = value;
+            }
+        }
+    }
+
+    size_t getNumRects() const
+    {
+        return rects.size() - freeRects.size();
+    }
+
+    // Calls onRect(rect) for every merged solid rect, skipping empty slots.
+    template <typename F>
+    void forEachRect(F onRect) const
+    {
+        for (size_t i = 0; i < rects.size(); ++i)
+        {
+            if (tileRects[i].w > 0)
+            {
+                onRect(rects[i]);
+            }
+        }
+    }
+
+    // Calls onTile(rect) once for every merged solid rect overlapping area until it returns true.
+    template <typename F>
+    bool forEachSolid(const Rect& area, F onTile) const
+    {
+        if (rectIndex.empty())
+        {
+            return false;
+        }
+        if (++stamp == 0)
+        {
+            std::fill(rectStamp.begin(), rectStamp.end(), 0);
+            stamp = 1;
+        }
+
+        int32_t txMin = std::max(int32_t(floorf((area.x - left) / tileWidth)), 0);
+        int32_t txMax = std::min(int32_t(ceilf((area.x + area.w - left) / tileWidth)) - 1, width - 1);
+        int32_t tyMin = std::max(int32_t(floorf((top - (area.y + area.h)) / tileHeight)), 0);
+        int32_t tyMax = std::min(int32_t(ceilf((top - area.y) / tileHeight)) - 1, height - 1);
+        for (int32_t ty = tyMin; ty <= tyMax; ++ty)
+        {
+            for (int32_t tx = txMin; tx <= txMax; ++tx)
+            {
+                uint32_t i = rectIndex[size_t(width) * ty + tx];
+                if (i == 0 || rectStamp[i - 1] == stamp)
+                {
+                    continue;
+                }
+                rectStamp[i - 1] = stamp;
+                if (onTile(rects[i - 1]))
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool isHit(const Rect& area) const
+    {
+        return forEachSolid(area, [](const Rect&) { return true; });
+    }
+};
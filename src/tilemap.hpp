@@ -2,48 +2,243 @@
 
 #include "sprite.hpp"
 #include "entity.hpp"
-#include <nlohmann/json.hpp>
+#include "mapped_file.hpp"
+#include "byte_span.hpp"
+#include "tilemap_sax.hpp"
+#include <SDL.h>
 #include <cstdint>
-#include <fstream>
+#include <cstdio>
+#include <cstring>
 #include <vector>
+#include <algorithm>
+
+// Tile geometry for a kTileChunkSize x kTileChunkSize block of tiles, kept in a
+// static vertex buffer and only rebuilt when one of its tiles changes.
+struct TileChunk {
+    struct Run {
+        uint8_t idx;
+        GLint first;
+        GLsizei count;
+    };
+
+    GLuint vbo = 0;
+    bool dirty = true;
+    // one run per tileset index, sorted by index.
+    std::vector<Run> runs;
+};
+
+// Binary map written by TileMap::saveTileMapBinary and mapped by loadTileMap.
+// Little-endian. Offsets are from the start of the file and 4-byte aligned.
+//   tiles: width * height uint8_t, rows top to bottom
+//   rects: numRects TileRect, the collider's merged solid rects in tile units
+// The collider's per-tile rect index is rebuilt from the rects at load.
+struct TileMapFileHeader {
+    static constexpr uint32_t kVersion = 2;
+
+    char magic[4];
+    uint32_t version;
+    uint16_t width;
+    uint16_t height;
+    uint16_t tileWidth;
+    uint16_t tileHeight;
+    uint64_t tilesOffset;
+    uint64_t rectsOffset;
+    uint32_t numRects;
+    uint32_t reserved;
+};
+static_assert(sizeof(TileRect) == 8, "TileRect is stored as 4 uint16 in binary maps");
+static_assert(sizeof(TileMapFileHeader) == 40, "TileMapFileHeader has no implicit padding");
 
 struct TileMap {
+    static constexpr uint16_t kTileChunkSize = 16;
+
     uint8_t* tileLayer = nullptr;
     uint16_t width = 0;
     uint16_t height = 0;
     uint16_t tileWidth = 0;
     uint16_t tileHeight = 0;
-    std::vector<Entity> walls;
+    TileCollider collider;
+    std::vector<TileChunk> chunks;
+    uint16_t chunksX = 0;
+    uint16_t chunksY = 0;
+    // set when tileLayer points into a mapped binary map instead of a heap buffer.
+    MappedFile mapped;
+    // merged rects of a binary map, until createTileCollider adopts them. point
+    // into mapped, or into bakedRectStorage for a map loaded from memory.
+    const TileRect* bakedRects = nullptr;
+    uint32_t numBakedRects = 0;
+    std::vector<TileRect> bakedRectStorage;
 
+    // Loads a binary map if fileName has one, otherwise parses Tiled JSON.
     void loadTileMap(const char* fileName)
     {
+        PROFILE_SCOPE("TileMap::loadTileMap");
         assert(tileLayer == nullptr);
 
-        std::ifstream file(fileName);
-        assert(file.good());
-        nlohmann::json j;
-        file >> j;
-
-        width = j["width"].get<uint16_t>();
-        height = j["height"].get<uint16_t>();
-        tileWidth = j["tilewidth"].get<uint16_t>();
-        tileHeight = j["tileheight"].get<uint16_t>();
-        printf("loadTileMap: %s, width: %d, height: %d, tileWidth: %d, tileHeight: %d\n", fileName, width, height, tileWidth, tileHeight);
-        tileLayer = new uint8_t[width * height];
-        assert(tileLayer);
-        for (int i = 0; i < width * height; ++i)
+        uint64_t startTime = SDL_GetPerformanceCounter();
+        if (loadTileMapBinary(fileName))
         {
-            tileLayer[i] = j["layers"][0]["data"][i].get<uint8_t>();
+            printf("loadTileMap: binary, %.3f ms\n", double(SDL_GetPerformanceCounter() - startTime) * 1000.0 / SDL_GetPerformanceFrequency());
+            return;
         }
+        loadTileMapJSON(fileName);
+        printf("loadTileMap: json, %.3f ms\n", double(SDL_GetPerformanceCounter() - startTime) * 1000.0 / SDL_GetPerformanceFrequency());
+    }
+
+    // Points tileLayer and the merged collision rects straight at the mapped file.
+    // createTileCollider rebuilds the per-tile rect index from the rects.
+    bool loadTileMapBinary(const char* fileName)
+    {
+        if (!mapped.openMappedFile(fileName))
+        {
+            return false;
+        }
+        if (!isTileMapBinary({mapped.data, mapped.size}))
+        {
+            mapped.closeMappedFile();
+            return false;
+        }
+        readTileMapBinary(mapped.data, mapped.size, fileName);
+        return true;
+    }
+
+    // Streams the JSON through TileMapSAX so no per-tile json values are allocated.
+    void loadTileMapJSON(const char* fileName)
+    {
+        FILE* fp = fopen(fileName, "rb");
+        assert(fp);
+        TileMapSAX sax;
+        bool ok = nlohmann::json::sax_parse(fp, &sax);
+        fclose(fp);
+        assert(ok);
+        readTileMapSAX(sax, fileName);
+    }
+
+    // Loads either format from bytes in memory, e.g. an AssetPack entry. Everything
+    // is copied, so data may be freed as soon as this returns.
+    void loadTileMapFromMemory(ByteSpan data, const char* name)
+    {
+        PROFILE_SCOPE("TileMap::loadTileMapFromMemory");
+        assert(tileLayer == nullptr);
+
+        uint64_t startTime = SDL_GetPerformanceCounter();
+        if (isTileMapBinary(data))
+        {
+            readTileMapBinary(data.data, data.size, name);
+            uint8_t* tiles = new uint8_t[size_t(width) * height];
+            memcpy(tiles, tileLayer, size_t(width) * height);
+            tileLayer = tiles;
+            bakedRectStorage.assign(bakedRects, bakedRects + numBakedRects);
+            bakedRects = bakedRectStorage.data();
+            printf("loadTileMap: binary, %.3f ms\n", double(SDL_GetPerformanceCounter() - startTime) * 1000.0 / SDL_GetPerformanceFrequency());
+            return;
+        }
+        TileMapSAX sax;
+        bool ok = nlohmann::json::sax_parse(data.data, data.data + data.size, &sax);
+        assert(ok);
+        readTileMapSAX(sax, name);
+        printf("loadTileMap: json, %.3f ms\n", double(SDL_GetPerformanceCounter() - startTime) * 1000.0 / SDL_GetPerformanceFrequency());
+    }
+
+    static bool isTileMapBinary(ByteSpan data)
+    {
+        return data.size >= sizeof(TileMapFileHeader) && memcmp(data.data, "HNTM", 4) == 0;
+    }
+
+    void readTileMapBinary(const uint8_t* data, size_t size, const char* name)
+    {
+        const TileMapFileHeader* header = (const TileMapFileHeader*)data;
+        assert(header->version == TileMapFileHeader::kVersion);
+        uint64_t numTiles = uint64_t(header->width) * header->height;
+        assert(header->tilesOffset + numTiles <= size);
+        assert(header->rectsOffset + uint64_t(header->numRects) * sizeof(TileRect) <= size);
+
+        width = header->width;
+        height = header->height;
+        tileWidth = header->tileWidth;
+        tileHeight = header->tileHeight;
+        tileLayer = (uint8_t*)data + header->tilesOffset;
+        bakedRects = (const TileRect*)(data + header->rectsOffset);
+        numBakedRects = header->numRects;
+        printf("loadTileMap: %s, width: %d, height: %d, tileWidth: %d, tileHeight: %d\n", name, width, height, tileWidth, tileHeight);
+    }
+
+    void readTileMapSAX(TileMapSAX& sax, const char* name)
+    {
+        width = sax.width;
+        height = sax.height;
+        tileWidth = sax.tileWidth;
+        tileHeight = sax.tileHeight;
+        printf("loadTileMap: %s, width: %d, height: %d, tileWidth: %d, tileHeight: %d\n", name, width, height, tileWidth, tileHeight);
+        assert(sax.numTiles == size_t(width) * height);
+        tileLayer = sax.releaseTiles();
+        assert(tileLayer);
     }
 
     void unloadTileMap()
     {
         assert(tileLayer);
-        delete[] tileLayer;
+        if (Entity::tileCollider == &collider)
+        {
+            Entity::tileCollider = nullptr;
+        }
+        collider = TileCollider();
+        destroyTileChunks();
+        bakedRects = nullptr;
+        numBakedRects = 0;
+        bakedRectStorage = std::vector<TileRect>();
+        if (mapped.isOpen())
+        {
+            mapped.closeMappedFile();
+        }
+        else
+        {
+            delete[] tileLayer;
+        }
         tileLayer = nullptr;
     }
 
+    // Writes the map and its collider in the format loadTileMapBinary maps. Call after createTileCollider.
+    void saveTileMapBinary(const char* fileName) const
+    {
+        assert(tileLayer);
+        assert(collider.tiles == tileLayer);
+
+        auto align4 = [](uint64_t n) { return (n + 3) & ~uint64_t(3); };
+        uint64_t numTiles = uint64_t(width) * height;
+        TileMapFileHeader header = {};
+        memcpy(header.magic, "HNTM", 4);
+        header.version = TileMapFileHeader::kVersion;
+        header.width = width;
+        header.height = height;
+        header.tileWidth = tileWidth;
+        header.tileHeight = tileHeight;
+        header.tilesOffset = sizeof(TileMapFileHeader);
+        // slots emptied by setTile are skipped.
+        std::vector<TileRect> tileRects;
+        tileRects.reserve(collider.getNumRects());
+        for (const TileRect& r : collider.tileRects)
+        {
+            if (r.w > 0)
+            {
+                tileRects.push_back(r);
+            }
+        }
+        header.numRects = uint32_t(tileRects.size());
+        header.rectsOffset = align4(header.tilesOffset + numTiles);
+        uint64_t fileSize = header.rectsOffset + uint64_t(header.numRects) * sizeof(TileRect);
+
+        FILE* fp = fopen(fileName, "wb");
+        assert(fp);
+        static const uint8_t padding[4] = {0};
+        fwrite(&header, sizeof(header), 1, fp);
+        fwrite(tileLayer, 1, size_t(numTiles), fp);
+        fwrite(padding, 1, size_t(header.rectsOffset - (header.tilesOffset + numTiles)), fp);
+        fwrite(tileRects.data(), sizeof(TileRect), tileRects.size(), fp);
+        fclose(fp);
+        printf("saveTileMapBinary: %s, %llu bytes\n", fileName, (unsigned long long)fileSize);
+    }
+
     // top-left is (-1, -1) in 2x2 tiles
     uint8_t getTile(int16_t x, int16_t y)
     {
@@ -56,55 +251,177 @@ struct TileMap {
         return tileLayer[width * y + x];
     }
 
-    void createWallEntities()
+    // same coordinates as getTile. marks the tile's chunk for rebuild.
+    void setTile(int16_t x, int16_t y, uint8_t idx)
+    {
+        x += width / 2;
+        y += height / 2;
+        assert(x >= 0);
+        assert(y >= 0);
+        assert(x < width);
+        assert(y < height);
+        uint8_t& tile = tileLayer[width * y + x];
+        if (tile == idx)
+        {
+            return;
+        }
+        bool solidChanged = TileCollider::isSolid(tile) != TileCollider::isSolid(idx);
+        tile = idx;
+        if (solidChanged)
+        {
+            // the baked collision data no longer matches the layer.
+            bakedRects = nullptr;
+            bakedRectStorage = std::vector<TileRect>();
+        }
+
+        if (!chunks.empty())
+        {
+            chunks[chunksX * (y / kTileChunkSize) + (x / kTileChunkSize)].dirty = true;
+        }
+        if (solidChanged && collider.tiles == tileLayer)
+        {
+            collider.updateTile(x, y);
+        }
+    }
+
+    // Solid tiles collide straight from tileLayer. tile centers match drawTileMap.
+    void createTileCollider()
     {
-        float x = 0.0F;
-        float y = 0.0F;
+        PROFILE_SCOPE("TileMap::createTileCollider");
+        assert(tileLayer);
+        collider.tiles = tileLayer;
+        collider.width = width;
+        collider.height = height;
+        collider.tileWidth = tileWidth;
+        collider.tileHeight = tileHeight;
+        collider.left = -(width * tileWidth / 2.0F) - tileWidth / 2.0F;
+        collider.top = height * tileHeight / 2.0F + tileHeight / 2.0F;
+        if (bakedRects)
+        {
+            collider.assign(bakedRects, numBakedRects);
+            // adopted by the collider, which keeps its own copy.
+            bakedRects = nullptr;
+            bakedRectStorage = std::vector<TileRect>();
+        }
+        else
+        {
+            collider.build();
+        }
+        Entity::tileCollider = &collider;
+
+        size_t numSolid = std::count_if(tileLayer, tileLayer + size_t(width) * height, TileCollider::isSolid);
+        printf("createTileCollider: solid tiles: %zu, merged rects: %zu\n", numSolid, collider.getNumRects());
+    }
+
+    void destroyTileChunks()
+    {
+        for (TileChunk& chunk : chunks)
+        {
+            if (chunk.vbo)
+            {
+                glDeleteBuffers(1, &chunk.vbo);
+            }
+        }
+        chunks.clear();
+        chunksX = 0;
+        chunksY = 0;
+    }
+
+    void buildTileChunk(TileChunk& chunk, uint16_t cx, uint16_t cy, const Sprite* tilesets)
+    {
+        struct TileQuad {
+            uint8_t idx;
+            SpriteBatch::Vertex quad[4];
+        };
+        std::vector<TileQuad> quads;
+
         float offsetX = width * tileWidth / 2.0F;
         float offsetY = height * tileHeight / 2.0F;
-        for (uint16_t ty = 0; ty < height; ++ty)
+        uint16_t txEnd = std::min<uint16_t>(uint16_t((cx + 1) * kTileChunkSize), width);
+        uint16_t tyEnd = std::min<uint16_t>(uint16_t((cy + 1) * kTileChunkSize), height);
+        for (uint16_t ty = cy * kTileChunkSize; ty < tyEnd; ++ty)
         {
-            y = float(ty) * tileHeight;
-            for (uint16_t tx = 0; tx < width; ++tx)
+            float y = float(ty) * tileHeight;
+            for (uint16_t tx = cx * kTileChunkSize; tx < txEnd; ++tx)
             {
-                x = float(tx) * tileWidth;
+                float x = float(tx) * tileWidth;
                 uint8_t idx = tileLayer[width * ty + tx];
                 if (idx > 1)
                 {
-                    Entity e;
-                    e.id = Entity::genID();
-                    e.position.x = x - offsetX;
-                    e.position.y = (y - offsetY) * -1.0F;
-                    e.hitbox.x = -4.0F;
-                    e.hitbox.y = -4.0F;
-                    e.hitbox.w = 8.0F;
-                    e.hitbox.h = 8.0F;
-                    walls.push_back(e);
+                    TileQuad q;
+                    q.idx = idx;
+                    tilesets[idx].buildQuad(q.quad, x - offsetX, (y - offsetY) * -1.0F);
+                    quads.push_back(q);
                 }
             }
         }
-        for (Entity& e : walls)
+        std::stable_sort(quads.begin(), quads.end(), [](const TileQuad& a, const TileQuad& b) { return a.idx < b.idx; });
+
+        std::vector<SpriteBatch::Vertex> vertices;
+        vertices.reserve(quads.size() * 6);
+        chunk.runs.clear();
+        for (const TileQuad& q : quads)
+        {
+            if (chunk.runs.empty() || chunk.runs.back().idx != q.idx)
+            {
+                chunk.runs.push_back({q.idx, GLint(vertices.size()), 0});
+            }
+            SpriteBatch::appendQuad(vertices, q.quad);
+            chunk.runs.back().count += 6;
+        }
+
+        if (!chunk.vbo)
         {
-            Entity::addEntity(&e);
+            glGenBuffers(1, &chunk.vbo);
+            assert(chunk.vbo);
         }
+        glBindBuffer(GL_ARRAY_BUFFER, chunk.vbo);
+        glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(vertices.size() * sizeof(SpriteBatch::Vertex)), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        chunk.dirty = false;
     }
 
     void drawTileMap(const Sprite* tilesets)
     {
-        float x = 0.0F;
-        float y = 0.0F;
-        float offsetX = width * tileWidth / 2.0F;
-        float offsetY = height * tileHeight / 2.0F;
-        for (uint16_t ty = 0; ty < height; ++ty)
+        PROFILE_SCOPE("TileMap::drawTileMap");
+        if (chunks.empty())
         {
-            y = float(ty) * tileHeight;
-            for (uint16_t tx = 0; tx < width; ++tx)
+            chunksX = uint16_t((width + kTileChunkSize - 1) / kTileChunkSize);
+            chunksY = uint16_t((height + kTileChunkSize - 1) / kTileChunkSize);
+            chunks.resize(size_t(chunksX) * chunksY);
+        }
+
+        assert(SpriteBatch::current);
+
+        // clip to the chunks overlapping the batch's view, with a tile of slack for
+        // tileset sprites larger than a tile.
+        int32_t cxMin = 0, cxMax = chunksX - 1;
+        int32_t cyMin = 0, cyMax = chunksY - 1;
+        if (SpriteBatch::current->cull)
+        {
+            const Rect& view = SpriteBatch::current->view;
+            float chunkW = float(kTileChunkSize * tileWidth);
+            float chunkH = float(kTileChunkSize * tileHeight);
+            float left = -(width * tileWidth / 2.0F) - tileWidth / 2.0F;
+            float top = height * tileHeight / 2.0F + tileHeight / 2.0F;
+            cxMin = std::max(int32_t(floorf((view.x - tileWidth - left) / chunkW)), cxMin);
+            cxMax = std::min(int32_t(floorf((view.x + view.w + tileWidth - left) / chunkW)), cxMax);
+            cyMin = std::max(int32_t(floorf((top - (view.y + view.h + tileHeight)) / chunkH)), cyMin);
+            cyMax = std::min(int32_t(floorf((top - (view.y - tileHeight)) / chunkH)), cyMax);
+        }
+
+        for (int32_t cy = cyMin; cy <= cyMax; ++cy)
+        {
+            for (int32_t cx = cxMin; cx <= cxMax; ++cx)
             {
-                x = float(tx) * tileWidth;
-                uint8_t idx = tileLayer[width * ty + tx];
-                if (idx > 1)
+                TileChunk& chunk = chunks[chunksX * cy + cx];
+                if (chunk.dirty)
+                {
+                    buildTileChunk(chunk, uint16_t(cx), uint16_t(cy), tilesets);
+                }
+                for (const TileChunk::Run& run : chunk.runs)
                 {
-                    tilesets[idx].drawSprite(x - offsetX, (y - offsetY) * -1.0F);
+                    SpriteBatch::current->drawBuffer(chunk.vbo, tilesets[run.idx].getTexID(), run.first, run.count);
                 }
             }
         }
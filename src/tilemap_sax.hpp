@@ -0,0 +1,190 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// nlohmann::json SAX handler that reads a Tiled JSON map without building a DOM.
+// Picks the map size keys out of the root object and narrows the first layer's
+// "data" values straight into tiles. Tiled writes "width" after "layers", so
+// tiles grows by doubling as values arrive and is handed over as-is.
+struct TileMapSAX {
+    using json = nlohmann::json;
+
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint16_t tileWidth = 0;
+    uint16_t tileHeight = 0;
+    uint8_t* tiles = nullptr;
+    size_t numTiles = 0;
+    size_t capacity = 0;
+
+    // nesting depth of the current value. the root object is depth 1.
+    uint32_t depth = 0;
+    std::string rootKey;
+    std::string layerKey;
+    int32_t layerIndex = -1;
+    bool inLayers = false;
+    bool inData = false;
+
+    ~TileMapSAX()
+    {
+        delete[] tiles;
+    }
+
+    // Passes ownership of tiles to the caller.
+    uint8_t* releaseTiles()
+    {
+        uint8_t* p = tiles;
+        tiles = nullptr;
+        numTiles = 0;
+        capacity = 0;
+        return p;
+    }
+
+    void pushTile(uint8_t idx)
+    {
+        if (numTiles == capacity)
+        {
+            size_t newCapacity = capacity ? capacity * 2 : 4096;
+            uint8_t* p = new uint8_t[newCapacity];
+            if (tiles)
+            {
+                memcpy(p, tiles, numTiles);
+                delete[] tiles;
+            }
+            tiles = p;
+            capacity = newCapacity;
+        }
+        tiles[numTiles++] = idx;
+    }
+
+    bool number(uint64_t val)
+    {
+        if (inData)
+        {
+            pushTile(uint8_t(val));
+        }
+        else if (depth == 1)
+        {
+            if (rootKey == "width")
+            {
+                width = uint16_t(val);
+            }
+            else if (rootKey == "height")
+            {
+                height = uint16_t(val);
+            }
+            else if (rootKey == "tilewidth")
+            {
+                tileWidth = uint16_t(val);
+            }
+            else if (rootKey == "tileheight")
+            {
+                tileHeight = uint16_t(val);
+            }
+        }
+        return true;
+    }
+
+    bool null()
+    {
+        return true;
+    }
+
+    bool boolean(bool)
+    {
+        return true;
+    }
+
+    bool number_integer(json::number_integer_t val)
+    {
+        return number(uint64_t(val));
+    }
+
+    bool number_unsigned(json::number_unsigned_t val)
+    {
+        return number(val);
+    }
+
+    bool number_float(json::number_float_t, const json::string_t&)
+    {
+        return true;
+    }
+
+    bool string(json::string_t&)
+    {
+        return true;
+    }
+
+    bool binary(json::binary_t&)
+    {
+        return true;
+    }
+
+    bool start_object(size_t)
+    {
+        depth++;
+        if (inLayers && depth == 3)
+        {
+            layerIndex++;
+        }
+        return true;
+    }
+
+    bool key(json::string_t& val)
+    {
+        if (depth == 1)
+        {
+            rootKey = val;
+        }
+        else if (inLayers && depth == 3)
+        {
+            layerKey = val;
+        }
+        return true;
+    }
+
+    bool end_object()
+    {
+        depth--;
+        return true;
+    }
+
+    bool start_array(size_t)
+    {
+        depth++;
+        if (depth == 2 && rootKey == "layers")
+        {
+            inLayers = true;
+        }
+        else if (inLayers && depth == 4 && layerIndex == 0 && layerKey == "data")
+        {
+            inData = true;
+        }
+        return true;
+    }
+
+    bool end_array()
+    {
+        if (depth == 2)
+        {
+            inLayers = false;
+        }
+        else if (depth == 4)
+        {
+            inData = false;
+        }
+        depth--;
+        return true;
+    }
+
+    bool parse_error(size_t position, const std::string& lastToken, const nlohmann::detail::exception& ex)
+    {
+        printf("TileMapSAX: parse error at %zu near '%s': %s\n", position, lastToken.c_str(), ex.what());
+        return false;
+    }
+};